@@ -43,6 +43,11 @@ int vc_bgr_para_cinzento(IVC* origem, IVC* destino);
  */
 int vc_cinzento_para_binario(IVC* origem, IVC* destino, int limiar);
 
+/**
+ * Binariza e inverte numa s passagem (binrio seguido de negativo).
+ */
+int vc_cinzento_para_binario_invertido(IVC* origem, IVC* destino, int limiar);
+
 /**
  * Gera o negativo de uma imagem em tons de cinzento
  */
@@ -73,11 +78,22 @@ int vc_binario_abertura(IVC* origem, IVC* destino, int tamanho_kernel, IVC* temp
  */
 int vc_binario_fecho(IVC* origem, IVC* destino, int tamanho_kernel, IVC* temp);
 
+/**
+ * Produz a mscara das moedas (cinzento, binrio invertido, abertura e fecho) linha a linha,
+ * usando apenas buffers circulares de 4 * tamanho_kernel linhas.
+ */
+int vc_segmentacao_em_linhas(IVC* origem, IVC* mascara, int limiar, int tamanho_kernel, IVC* linhas);
+
  /**
   * Determina se o blob deve ser descartado com base na cor mdia
   */
 int vc_blob_cor_a_descartar(IVC* imagem_cor, OVC* info_blob, const char* nome_ficheiro);
 
+/**
+ * Igual a vc_blob_cor_a_descartar, mas a partir dos planos Y, U e V de uma imagem YUV 4:2:0.
+ */
+int vc_blob_cor_a_descartar_yuv(IVC* luma, IVC* croma_u, IVC* croma_v, OVC* info_blob, int gama_completa, const char* nome_ficheiro);
+
 /**
  * Desenha a caixa delimitadora de um blob numa imagem a cores.
  */
@@ -0,0 +1,63 @@
+﻿#include "alocacoes.h"
+
+#ifdef _DEBUG
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+// Alocações feitas pela thread atual (a thread de captura do modo em tempo real não interfere)
+static thread_local unsigned long long alocacoes_thread = 0;
+
+void* operator new(std::size_t tamanho) {
+    alocacoes_thread++;
+    if (tamanho == 0) tamanho = 1;
+
+    while (true) {
+        void* memoria = std::malloc(tamanho);
+        if (memoria) return memoria;
+
+        std::new_handler tratador = std::get_new_handler();
+        if (!tratador) throw std::bad_alloc();
+        tratador();
+    }
+}
+
+void* operator new[](std::size_t tamanho) {
+    return operator new(tamanho);
+}
+
+void operator delete(void* memoria) noexcept {
+    std::free(memoria);
+}
+
+void operator delete[](void* memoria) noexcept {
+    std::free(memoria);
+}
+
+void operator delete(void* memoria, std::size_t) noexcept {
+    std::free(memoria);
+}
+
+void operator delete[](void* memoria, std::size_t) noexcept {
+    std::free(memoria);
+}
+
+void VerificadorAlocacoesFrame::iniciarFrame() {
+    alocacoes_inicio = alocacoes_thread;
+}
+
+/**
+ * Função: terminarFrame
+ * Descrição: Conta o frame e, terminado o aquecimento, exige zero alocações desde iniciarFrame.
+ */
+void VerificadorAlocacoesFrame::terminarFrame() {
+    unsigned long long alocacoes_frame = alocacoes_thread - alocacoes_inicio;
+    frames_verificados++;
+
+    if (frames_verificados > frames_aquecimento && alocacoes_frame != 0) {
+        std::cerr << "Erro: " << alocacoes_frame << " alocacoes no heap no frame " << frames_verificados << " (regime estavel).\n";
+        assert(alocacoes_frame == 0);
+    }
+}
+#endif
@@ -0,0 +1,35 @@
+﻿#ifndef ALOCACOES_H
+#define ALOCACOES_H
+
+/*
+ * Verificação de alocações no ciclo de frames (apenas em builds de depuração, _DEBUG).
+ * alocacoes.cpp substitui o operator new global e conta as alocações de cada thread.
+ * Só são contadas as alocações feitas pelo código deste programa: as DLLs do OpenCV
+ * usam o seu próprio operator new (por exemplo, nas estruturas internas de cv::findContours).
+ * Em release a verificação não faz nada.
+ */
+
+/**
+ * Classe: VerificadorAlocacoesFrame
+ * Descrição: Mede as alocações entre iniciarFrame e terminarFrame e, depois dos frames de
+ *            aquecimento, falha (assert) se algum frame tiver alocado memória no heap.
+ */
+class VerificadorAlocacoesFrame {
+public:
+    explicit VerificadorAlocacoesFrame(int frames_aquecimento = 30) : frames_aquecimento(frames_aquecimento) {}
+
+#ifdef _DEBUG
+    void iniciarFrame();
+    void terminarFrame();
+#else
+    void iniciarFrame() {}
+    void terminarFrame() {}
+#endif
+
+private:
+    int frames_aquecimento;
+    long long frames_verificados = 0;
+    unsigned long long alocacoes_inicio = 0;
+};
+
+#endif // ALOCACOES_H
@@ -0,0 +1,395 @@
+﻿#include "contagem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const char* const TIPOS_MOEDA[NUM_TIPOS_MOEDA] = { "1c", "2c", "5c", "10c", "20c", "50c", "1euro", "2euro" };
+
+/**
+ * Função: parametrosParaVideo
+ * Descrição: Devolve os parâmetros calibrados para o vídeo indicado.
+ */
+ParametrosContagem parametrosParaVideo(const std::string& nome_video) {
+    ParametrosContagem parametros;
+    parametros.nome_video = nome_video;
+
+    if (nome_video == "video1.mp4") {
+        parametros.limiar_binarizacao = 110;
+    }
+    else if (nome_video == "video2.mp4") {
+        parametros.limiar_binarizacao = 120;
+    }
+    return parametros;
+}
+
+// Regras de área para o video1.mp4 (pela ordem de TipoMoeda). As bandas não se sobrepõem,
+// para que sejam os limites reais da classificação (10c e 20c começam onde 2c e 5c acabam)
+static const BandaArea BANDAS_VIDEO1[NUM_TIPOS_MOEDA] = {
+    { 10600, 11400 }, { 13800, 14850 }, { 17800, 18900 }, { 14850, 15800 },
+    { 18900, 20000 }, { 23300, 24300 }, { 20500, 22300 }, { 26200, 27300 }
+};
+
+// Regras de área para o video2.mp4
+static const BandaArea BANDAS_VIDEO2[NUM_TIPOS_MOEDA] = {
+    { 10000, 12100 }, { 13400, 15090 }, { 17100, 19500 }, { 15100, 17000 },
+    { 19600, 21900 }, { 23700, 26000 }, { 22000, 23600 }, { 27000, 28200 }
+};
+
+static const BandaArea* bandasParaVideo(const std::string& nome_video) {
+    if (nome_video == "video1.mp4") return BANDAS_VIDEO1;
+    if (nome_video == "video2.mp4") return BANDAS_VIDEO2;
+    return nullptr;
+}
+
+/**
+ * Função: identificarTipoMoeda
+ * Descrição: Identifica o tipo de moeda.
+ */
+TipoMoeda identificarTipoMoeda(double area, const std::string& nome_video) {
+    const BandaArea* bandas = bandasParaVideo(nome_video);
+    if (!bandas) return MOEDA_DESCONHECIDA;
+
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) {
+        if (area >= bandas[i].minimo && area < bandas[i].maximo) return static_cast<TipoMoeda>(i);
+    }
+    return MOEDA_DESCONHECIDA;
+}
+
+/**
+ * Função: bandaAreaMoeda
+ * Descrição: Devolve a banda de área usada por identificarTipoMoeda para o tipo indicado.
+ * Retorna: false se o vídeo não tiver regras ou o tipo for desconhecido.
+ */
+bool bandaAreaMoeda(TipoMoeda tipo_moeda, const std::string& nome_video, BandaArea& banda) {
+    const BandaArea* bandas = bandasParaVideo(nome_video);
+    if (!bandas || tipo_moeda < 0 || tipo_moeda >= NUM_TIPOS_MOEDA) return false;
+    banda = bandas[tipo_moeda];
+    return true;
+}
+
+/**
+ * Função: valorMoeda
+ * Descrição: Devolve o valor em euros de um tipo de moeda (0 se for desconhecido).
+ */
+double valorMoeda(TipoMoeda tipo_moeda) {
+    static const double VALORES_MOEDA[NUM_TIPOS_MOEDA] = { 0.01, 0.02, 0.05, 0.10, 0.20, 0.50, 1.00, 2.00 };
+    return (tipo_moeda >= 0 && tipo_moeda < NUM_TIPOS_MOEDA) ? VALORES_MOEDA[tipo_moeda] : 0.0;
+}
+
+const char* nomeTipoMoeda(TipoMoeda tipo_moeda) {
+    return (tipo_moeda >= 0 && tipo_moeda < NUM_TIPOS_MOEDA) ? TIPOS_MOEDA[tipo_moeda] : "Desconhecida";
+}
+
+/**
+ * Função: tipoMoedaDeTexto
+ * Descrição: Procura o nome em TIPOS_MOEDA.
+ */
+TipoMoeda tipoMoedaDeTexto(const std::string& texto) {
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) {
+        if (texto == TIPOS_MOEDA[i]) return static_cast<TipoMoeda>(i);
+    }
+    return MOEDA_DESCONHECIDA;
+}
+
+/**
+ * Função: calcularPropriedadesBlob
+ * Descrição: Calcula a caixa delimitadora e o centroide de um contorno.
+ */
+void calcularPropriedadesBlob(const std::vector<cv::Point>& contorno, OVC& info_blob) {
+    if (contorno.empty()) return;
+
+    int min_x = contorno[0].x, max_x = contorno[0].x;
+    int min_y = contorno[0].y, max_y = contorno[0].y;
+    long long soma_x = 0, soma_y = 0;
+
+    for (const auto& ponto : contorno) {
+        soma_x += ponto.x;
+        soma_y += ponto.y;
+        if (ponto.x < min_x) min_x = ponto.x;
+        if (ponto.x > max_x) max_x = ponto.x;
+        if (ponto.y < min_y) min_y = ponto.y;
+        if (ponto.y > max_y) max_y = ponto.y;
+    }
+
+    info_blob.x = min_x;
+    info_blob.y = min_y;
+    info_blob.width = max_x - min_x + 1;
+    info_blob.height = max_y - min_y + 1;
+    info_blob.xc = static_cast<int>(soma_x / contorno.size());
+    info_blob.yc = static_cast<int>(soma_y / contorno.size());
+}
+
+// Função para calcular o perímetro de um contorno
+double calcularPerimetro(const std::vector<cv::Point>& contorno) {
+    double perimetro = 0.0;
+    if (contorno.size() < 2) return 0.0;
+
+    for (size_t i = 0; i < contorno.size(); ++i) {
+        // Ponto atual
+        cv::Point p1 = contorno[i];
+        // Próximo ponto (o operador % garante que o último ponto é ligado ao primeiro)
+        cv::Point p2 = contorno[(i + 1) % contorno.size()];
+
+        // Usa std::hypot para maior precisão e segurança numérica
+        perimetro += std::hypot(p2.x - p1.x, p2.y - p1.y);
+    }
+
+    return perimetro;
+}
+
+/**
+ * Função: criarImagensTrabalho
+ * Descrição: Aloca as imagens intermédias para frames com as dimensões indicadas.
+ * Retorna: true em caso de sucesso, false em caso de erro.
+ */
+bool criarImagensTrabalho(ImagensTrabalho& imagens, int largura, int altura, const ParametrosContagem& parametros, bool com_cor) {
+    if (parametros.segmentacao_em_linhas) {
+        imagens.binaria = vc_imagem_nova(largura, altura, 1, 255);
+        imagens.linhas = vc_imagem_nova(largura, 4 * parametros.tamanho_kernel_morfologia, 1, 255);
+        if (!imagens.binaria || !imagens.linhas) {
+            libertarImagensTrabalho(imagens);
+            return false;
+        }
+        return true;
+    }
+
+    if (com_cor) {
+        imagens.cor = vc_imagem_nova(largura, altura, 3, 255);
+        imagens.cinza = vc_imagem_nova(largura, altura, 1, 255);
+    }
+    imagens.binaria = vc_imagem_nova(largura, altura, 1, 255);
+    imagens.temp = vc_imagem_nova(largura, altura, 1, 255);
+
+    if ((com_cor && (!imagens.cor || !imagens.cinza)) || !imagens.binaria || !imagens.temp) {
+        libertarImagensTrabalho(imagens);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Função: libertarImagensTrabalho
+ * Descrição: Liberta as imagens intermédias.
+ */
+void libertarImagensTrabalho(ImagensTrabalho& imagens) {
+    if (imagens.cor == &imagens.vista_cor) imagens.cor = nullptr;
+    imagens.cor = vc_imagem_free(imagens.cor);
+    imagens.cinza = vc_imagem_free(imagens.cinza);
+    imagens.binaria = vc_imagem_free(imagens.binaria);
+    imagens.temp = vc_imagem_free(imagens.temp);
+    imagens.linhas = vc_imagem_free(imagens.linhas);
+}
+
+/**
+ * Função: iniciarSessaoContagem
+ * Descrição: Cria as imagens de trabalho, coloca a linha de contagem a 1/3 da altura e reserva
+ *            os contentores do ciclo de frames com folga para o número de moedas visíveis.
+ * Retorna: true em caso de sucesso, false em caso de erro.
+ */
+bool iniciarSessaoContagem(SessaoContagem& sessao, int largura, int altura, const ParametrosContagem& parametros, bool com_cor) {
+    if (!criarImagensTrabalho(sessao.imagens, largura, altura, parametros, com_cor)) return false;
+
+    sessao.tracking.linha_de_contagem_y = altura / 3;
+    sessao.tracking.objetos_rastreados.reserve(64);
+    sessao.imagens.contornos.reserve(256);
+    sessao.blobs.reserve(64);
+    sessao.eventos.reserve(16);
+    sessao.texto.reserve(64);
+    iniciarTotais(sessao.totais);
+    return true;
+}
+
+void terminarSessaoContagem(SessaoContagem& sessao) {
+    libertarImagensTrabalho(sessao.imagens);
+}
+
+/**
+ * Função: segmentarMoedas
+ * Descrição: Converte o frame para cinzento, binariza e inverte (numa só passagem) e aplica abertura e fecho.
+ */
+void segmentarMoedas(const cv::Mat& frame, ImagensTrabalho& imagens, const ParametrosContagem& parametros) {
+    if (imagens.linhas) {
+        // O frame é lido diretamente, sem cópia para uma imagem IVC própria
+        imagens.vista_cor.data = frame.data;
+        imagens.vista_cor.width = frame.cols;
+        imagens.vista_cor.height = frame.rows;
+        imagens.vista_cor.channels = 3;
+        imagens.vista_cor.levels = 255;
+        imagens.vista_cor.bytesperline = static_cast<int>(frame.step);
+        imagens.cor = &imagens.vista_cor;
+
+        vc_segmentacao_em_linhas(imagens.cor, imagens.binaria, parametros.limiar_binarizacao, parametros.tamanho_kernel_morfologia, imagens.linhas);
+        return;
+    }
+
+    memcpy(imagens.cor->data, frame.data, imagens.cor->width * imagens.cor->height * 3);
+
+    vc_bgr_para_cinzento(imagens.cor, imagens.cinza);
+    vc_cinzento_para_binario_invertido(imagens.cinza, imagens.binaria, parametros.limiar_binarizacao);
+    vc_binario_abertura(imagens.binaria, imagens.binaria, parametros.tamanho_kernel_morfologia, imagens.temp);
+    vc_binario_fecho(imagens.binaria, imagens.binaria, parametros.tamanho_kernel_morfologia, imagens.temp);
+}
+
+/**
+ * Função: segmentarMoedasLuma
+ * Descrição: Binariza diretamente o plano Y de uma fonte YUV e aplica inversão, abertura e fecho.
+ *            Na gama limitada (16-235) o limiar é convertido para o valor de luma equivalente
+ *            ao cinzento que seria obtido após a conversão para BGR.
+ */
+void segmentarMoedasLuma(IVC* luma, IVC* croma_u, IVC* croma_v, bool gama_completa, ImagensTrabalho& imagens, const ParametrosContagem& parametros) {
+    imagens.luma = luma;
+    imagens.croma_u = croma_u;
+    imagens.croma_v = croma_v;
+    imagens.gama_completa = gama_completa;
+
+    int limiar = parametros.limiar_binarizacao;
+    if (!gama_completa) limiar = 16 + (limiar * 219 + 127) / 255;
+
+    if (imagens.linhas) {
+        vc_segmentacao_em_linhas(luma, imagens.binaria, limiar, parametros.tamanho_kernel_morfologia, imagens.linhas);
+        return;
+    }
+
+    vc_cinzento_para_binario_invertido(luma, imagens.binaria, limiar);
+    vc_binario_abertura(imagens.binaria, imagens.binaria, parametros.tamanho_kernel_morfologia, imagens.temp);
+    vc_binario_fecho(imagens.binaria, imagens.binaria, parametros.tamanho_kernel_morfologia, imagens.temp);
+}
+
+/**
+ * Função: extrairBlobsValidos
+ * Descrição: Deteta os contornos e aplica os filtros de área, cor, proporção e circularidade.
+ */
+void extrairBlobsValidos(ImagensTrabalho& imagens, const ParametrosContagem& parametros, std::vector<BlobMoeda>& blobs) {
+    blobs.clear();
+
+    cv::Mat imagem_binaria_opencv(imagens.binaria->height, imagens.binaria->width, CV_8UC1, imagens.binaria->data);
+    cv::findContours(imagem_binaria_opencv, imagens.contornos, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+
+    for (const auto& contorno : imagens.contornos) {
+        double area = cv::contourArea(contorno);
+        if (area < parametros.area_minima) continue;
+
+        OVC info_blob = { 0 };
+        calcularPropriedadesBlob(contorno, info_blob);
+
+        int cor_a_descartar = imagens.croma_u
+            ? vc_blob_cor_a_descartar_yuv(imagens.luma, imagens.croma_u, imagens.croma_v, &info_blob, imagens.gama_completa, parametros.nome_video.c_str())
+            : vc_blob_cor_a_descartar(imagens.cor, &info_blob, parametros.nome_video.c_str());
+        if (cor_a_descartar) {
+            continue;
+        }
+
+        // FILTRO DE PROPORÇÃO
+        float proporcao = (float)info_blob.width / (float)info_blob.height;
+        if (proporcao < parametros.proporcao_minima || proporcao > parametros.proporcao_maxima) {
+            continue;
+        }
+
+        // FILTRO DE CIRCULARIDADE
+        double perimetro = calcularPerimetro(contorno);
+        if (perimetro == 0) continue;
+        double circularidade = (4 * 3.14159265359 * area) / (perimetro * perimetro);
+        if (circularidade < parametros.circularidade_minima) {
+            continue;
+        }
+
+        // Se o blob passou todos os filtros, guarda todas as informações
+        blobs.push_back({ info_blob, area, circularidade });
+    }
+}
+
+/**
+ * Função: iniciarTotais
+ * Descrição: Coloca a zero os totais.
+ */
+void iniciarTotais(TotaisContagem& totais) {
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) totais.contagem_por_tipo[i] = 0;
+    totais.valor_total_euros = 0.0;
+    totais.total_moedas_contadas = 0;
+}
+
+/**
+ * Função: atualizarTracking
+ * Descrição: Associa cada blob ao objeto rastreado mais próximo e deteta a passagem
+ *            pela linha de contagem (de baixo para cima).
+ * Parâmetros:
+ *   - estado: objetos rastreados
+ *   - blobs: blobs válidos do frame atual
+ *   - parametros: parâmetros de tracking
+ *   - frames_decorridos: frames da fonte desde o último frame processado (> 1 se houve frames saltados)
+ *   - indice_frame: índice do frame atual na fonte
+ *   - eventos: recebe as moedas que atravessaram a linha neste frame
+ */
+void atualizarTracking(EstadoTracking& estado, const std::vector<BlobMoeda>& blobs, const ParametrosContagem& parametros,
+    int frames_decorridos, long long indice_frame, std::vector<EventoContagem>& eventos) {
+    // Com frames descartados as moedas deslocam-se mais entre frames processados,
+    // por isso o raio de associação do tracking cresce com o intervalo
+    double raio_tracking = parametros.distancia_minima_tracking * std::min(std::max(frames_decorridos, 1), parametros.maximo_frames_saltados_tracking);
+    const int linha_de_contagem_y = estado.linha_de_contagem_y;
+
+    // A expiração conta frames processados e não índices da fonte: com dizimação o intervalo
+    // entre frames processados pode exceder frames_expiracao_tracking
+    for (auto& objeto : estado.objetos_rastreados) objeto.frames_sem_blob++;
+
+    for (const auto& blob : blobs) {
+        cv::Point centro_atual(blob.info.xc, blob.info.yc);
+        ObjetoRastreado* objeto_associado = nullptr;
+        double menor_distancia = raio_tracking;
+
+        for (auto& objeto : estado.objetos_rastreados) {
+            double dist = std::sqrt(std::pow(centro_atual.x - objeto.posicao.x, 2) + std::pow(centro_atual.y - objeto.posicao.y, 2));
+
+            if (dist < menor_distancia) {
+                menor_distancia = dist;
+                objeto_associado = &objeto;
+            }
+        }
+
+        if (objeto_associado) {
+            cv::Point pos_anterior = objeto_associado->posicao;
+            objeto_associado->posicao = centro_atual;
+            objeto_associado->frames_sem_blob = 0;
+
+            if (pos_anterior.y >= linha_de_contagem_y && centro_atual.y < linha_de_contagem_y && !objeto_associado->ja_contado) {
+                objeto_associado->ja_contado = true;
+                eventos.push_back({ indice_frame, identificarTipoMoeda(blob.area / parametros.escala_areas, parametros.nome_video), centro_atual,
+                    blob.area, blob.circularidade });
+            }
+        }
+        else {
+            if (centro_atual.y > linha_de_contagem_y) {
+                estado.objetos_rastreados.push_back({ estado.proximo_id_objeto, centro_atual, false, 0 });
+                estado.proximo_id_objeto++;
+            }
+        }
+    }
+
+    // Esquece os objetos que já não aparecem (moedas que saíram da imagem), para que o estado
+    // não cresça com o tempo; a remoção mantém a ordem por id
+    std::vector<ObjetoRastreado>& objetos = estado.objetos_rastreados;
+    objetos.erase(std::remove_if(objetos.begin(), objetos.end(), [&](const ObjetoRastreado& objeto) {
+        return objeto.frames_sem_blob > parametros.frames_expiracao_tracking;
+    }), objetos.end());
+}
+
+/**
+ * Função: registarContagem
+ * Descrição: Acrescenta uma moeda contada aos totais.
+ */
+void registarContagem(TotaisContagem& totais, const EventoContagem& evento) {
+    totais.total_moedas_contadas++;
+    if (evento.tipo_moeda != MOEDA_DESCONHECIDA) {
+        totais.contagem_por_tipo[evento.tipo_moeda]++;
+        totais.valor_total_euros += valorMoeda(evento.tipo_moeda);
+    }
+}
+
+/**
+ * Função: juntarTotais
+ * Descrição: Soma os totais de origem aos totais de destino.
+ */
+void juntarTotais(TotaisContagem& destino, const TotaisContagem& origem) {
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) destino.contagem_por_tipo[i] += origem.contagem_por_tipo[i];
+    destino.valor_total_euros += origem.valor_total_euros;
+    destino.total_moedas_contadas += origem.total_moedas_contadas;
+}
@@ -0,0 +1,211 @@
+﻿#ifndef CONTAGEM_H
+#define CONTAGEM_H
+
+#include <opencv2/opencv.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "Header.h"
+}
+
+/**
+ * Enumeração: TipoMoeda
+ * Descrição: Tipos de moeda reconhecidos por identificarTipoMoeda, pela ordem de TIPOS_MOEDA.
+ */
+enum TipoMoeda {
+    MOEDA_1C, MOEDA_2C, MOEDA_5C, MOEDA_10C, MOEDA_20C, MOEDA_50C, MOEDA_1EURO, MOEDA_2EURO,
+    MOEDA_DESCONHECIDA
+};
+
+const int NUM_TIPOS_MOEDA = MOEDA_DESCONHECIDA;
+extern const char* const TIPOS_MOEDA[NUM_TIPOS_MOEDA];
+
+/**
+ * Estrutura: BandaArea
+ * Descrição: Intervalo de área [minimo, maximo) de um tipo de moeda.
+ */
+struct BandaArea {
+    double minimo;
+    double maximo;
+};
+
+/**
+ * Estrutura: ParametrosContagem
+ * Descrição: Parâmetros de segmentação, filtragem de blobs e tracking.
+ */
+struct ParametrosContagem {
+    std::string nome_video;                 // Define também as regras de classificação
+    int limiar_binarizacao = 110;
+    int distancia_minima_tracking = 40;
+    int tamanho_kernel_morfologia = 3;
+    double area_minima = 1500;
+    float proporcao_minima = 0.8f;
+    float proporcao_maxima = 1.1f;
+    double circularidade_minima = 0.40;
+    double escala_areas = 1.0;              // Fator aplicado às bandas de área de identificarTipoMoeda
+    int maximo_frames_saltados_tracking = 8; // Limite para o alargamento do raio de tracking
+    int frames_expiracao_tracking = 60;     // Objetos sem blob associado durante mais frames processados deixam de ser rastreados
+    bool segmentacao_em_linhas = false;     // Segmentação linha a linha, sem imagens intermédias completas
+};
+
+/**
+ * Estrutura: BlobMoeda
+ * Descrição: Blob que passou todos os filtros, com as propriedades calculadas.
+ */
+struct BlobMoeda {
+    OVC info;
+    double area;
+    double circularidade;
+};
+
+/**
+ * Estrutura: EventoContagem
+ * Descrição: Registo de uma moeda que atravessou a linha de contagem.
+ */
+struct EventoContagem {
+    long long indice_frame;
+    TipoMoeda tipo_moeda;
+    cv::Point centro;
+    double area;                    // Medidas do blob no frame em que foi contado
+    double circularidade;
+};
+
+/**
+ * Estrutura: ObjetoRastreado
+ * Descrição: Objeto seguido pelo tracking.
+ */
+struct ObjetoRastreado {
+    int id;
+    cv::Point posicao;
+    bool ja_contado;
+    int frames_sem_blob;            // Frames processados desde a última associação a um blob
+};
+
+/**
+ * Estrutura: EstadoTracking
+ * Descrição: Objetos rastreados entre frames.
+ */
+struct EstadoTracking {
+    int linha_de_contagem_y = 0;
+    int proximo_id_objeto = 0;
+    std::vector<ObjetoRastreado> objetos_rastreados;   // Por ordem de id
+};
+
+/**
+ * Estrutura: TotaisContagem
+ * Descrição: Totais acumulados (por tipo e em euros).
+ */
+struct TotaisContagem {
+    int contagem_por_tipo[NUM_TIPOS_MOEDA] = {};    // Indexado por TipoMoeda
+    double valor_total_euros = 0.0;
+    int total_moedas_contadas = 0;
+};
+
+/**
+ * Estrutura: ImagensTrabalho
+ * Descrição: Imagens IVC intermédias usadas na segmentação de um frame.
+ */
+struct ImagensTrabalho {
+    IVC* cor = nullptr;
+    IVC* cinza = nullptr;
+    IVC* binaria = nullptr;
+    IVC* temp = nullptr;
+
+    // Segmentação em linhas: buffers circulares e cabeçalho IVC sobre os dados do frame
+    // (neste modo 'cor' aponta para vista_cor e não há cópia do frame)
+    IVC* linhas = nullptr;
+    IVC vista_cor = {};
+
+    // Planos de uma fonte YUV (não pertencem a esta estrutura); quando definidos,
+    // o filtro de cor usa-os em vez da imagem 'cor'
+    IVC* luma = nullptr;
+    IVC* croma_u = nullptr;
+    IVC* croma_v = nullptr;
+    bool gama_completa = false;
+
+    // Contornos do último frame; reutilizados para manter a capacidade entre frames
+    std::vector<std::vector<cv::Point>> contornos;
+};
+
+/**
+ * Estrutura: SessaoContagem
+ * Descrição: Tudo o que o ciclo de frames usa. Os contentores são reservados em iniciarSessaoContagem
+ *            e reutilizados em todos os frames, pelo que em regime estável o ciclo não faz alocações.
+ */
+struct SessaoContagem {
+    ImagensTrabalho imagens;
+    EstadoTracking tracking;
+    TotaisContagem totais;
+    std::vector<BlobMoeda> blobs;
+    std::vector<EventoContagem> eventos;
+    std::string texto;              // Texto das anotações (cv::putText recebe std::string)
+};
+
+/**
+ * Devolve os parâmetros calibrados para o vídeo indicado.
+ */
+ParametrosContagem parametrosParaVideo(const std::string& nome_video);
+
+TipoMoeda identificarTipoMoeda(double area, const std::string& nome_video);
+
+/**
+ * Devolve a banda de área do tipo nas regras do vídeo indicado (false se não existir).
+ */
+bool bandaAreaMoeda(TipoMoeda tipo_moeda, const std::string& nome_video, BandaArea& banda);
+double valorMoeda(TipoMoeda tipo_moeda);
+
+/**
+ * Devolve o nome do tipo ("Desconhecida" para MOEDA_DESCONHECIDA).
+ */
+const char* nomeTipoMoeda(TipoMoeda tipo_moeda);
+
+/**
+ * Devolve o tipo com o nome indicado (ex.: "2euro"), ou MOEDA_DESCONHECIDA.
+ */
+TipoMoeda tipoMoedaDeTexto(const std::string& texto);
+void calcularPropriedadesBlob(const std::vector<cv::Point>& contorno, OVC& info_blob);
+double calcularPerimetro(const std::vector<cv::Point>& contorno);
+
+/**
+ * Aloca as imagens intermédias; sem com_cor apenas são criadas a binária e a temporária (fontes YUV).
+ * Com parametros.segmentacao_em_linhas apenas são criadas a binária e os buffers de linhas.
+ */
+bool criarImagensTrabalho(ImagensTrabalho& imagens, int largura, int altura, const ParametrosContagem& parametros, bool com_cor = true);
+void libertarImagensTrabalho(ImagensTrabalho& imagens);
+
+/**
+ * Copia o frame para imagens.cor e produz a máscara binária das moedas em imagens.binaria.
+ */
+void segmentarMoedas(const cv::Mat& frame, ImagensTrabalho& imagens, const ParametrosContagem& parametros);
+
+/**
+ * Segmenta diretamente a partir do plano Y de uma fonte YUV, sem conversões de cor.
+ * Os planos indicados ficam associados a imagens para o filtro de cor.
+ */
+void segmentarMoedasLuma(IVC* luma, IVC* croma_u, IVC* croma_v, bool gama_completa, ImagensTrabalho& imagens, const ParametrosContagem& parametros);
+
+/**
+ * Extrai os contornos da máscara binária e devolve os blobs que passam os filtros.
+ */
+void extrairBlobsValidos(ImagensTrabalho& imagens, const ParametrosContagem& parametros, std::vector<BlobMoeda>& blobs);
+
+/**
+ * Cria as imagens de trabalho e reserva os contentores da sessão.
+ */
+bool iniciarSessaoContagem(SessaoContagem& sessao, int largura, int altura, const ParametrosContagem& parametros, bool com_cor = true);
+void terminarSessaoContagem(SessaoContagem& sessao);
+
+void iniciarTotais(TotaisContagem& totais);
+
+/**
+ * Associa os blobs aos objetos rastreados e acrescenta a eventos as moedas que atravessaram a linha.
+ */
+void atualizarTracking(EstadoTracking& estado, const std::vector<BlobMoeda>& blobs, const ParametrosContagem& parametros,
+    int frames_decorridos, long long indice_frame, std::vector<EventoContagem>& eventos);
+
+void registarContagem(TotaisContagem& totais, const EventoContagem& evento);
+void juntarTotais(TotaisContagem& destino, const TotaisContagem& origem);
+
+#endif // CONTAGEM_H
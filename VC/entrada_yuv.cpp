@@ -0,0 +1,237 @@
+﻿#include "entrada_yuv.h"
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LeitorYUV::~LeitorYUV() {
+    fechar();
+}
+
+/**
+ * Função: mapear
+ * Descrição: Mapeia o ficheiro inteiro em memória com cópia na escrita: o ficheiro é aberto só para
+ *            leitura, mas uma escrita nos planos (p.ex. uma operação de vc.c com origem e destino iguais)
+ *            copia a página em vez de falhar, e o ficheiro nunca é alterado.
+ */
+bool LeitorYUV::mapear(const std::string& caminho) {
+    fechar();
+
+#ifdef _WIN32
+    HANDLE handle_ficheiro = CreateFileA(caminho.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle_ficheiro == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER tamanho_ficheiro;
+    if (!GetFileSizeEx(handle_ficheiro, &tamanho_ficheiro) || tamanho_ficheiro.QuadPart == 0) {
+        CloseHandle(handle_ficheiro);
+        return false;
+    }
+
+    HANDLE handle_mapeamento = CreateFileMappingA(handle_ficheiro, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (handle_mapeamento == NULL) {
+        CloseHandle(handle_ficheiro);
+        return false;
+    }
+
+    void* vista = MapViewOfFile(handle_mapeamento, FILE_MAP_COPY, 0, 0, 0);
+    if (vista == NULL) {
+        CloseHandle(handle_mapeamento);
+        CloseHandle(handle_ficheiro);
+        return false;
+    }
+
+    ficheiro = handle_ficheiro;
+    mapeamento = handle_mapeamento;
+    tamanho = static_cast<size_t>(tamanho_ficheiro.QuadPart);
+    dados = static_cast<unsigned char*>(vista);
+#else
+    int fd = open(caminho.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* vista = mmap(NULL, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (vista == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    // Os frames são lidos por ordem
+    madvise(vista, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+    descritor = fd;
+    tamanho = static_cast<size_t>(info.st_size);
+    dados = static_cast<unsigned char*>(vista);
+#endif
+    return true;
+}
+
+/**
+ * Função: fechar
+ * Descrição: Desfaz o mapeamento e fecha o ficheiro.
+ */
+void LeitorYUV::fechar() {
+#ifdef _WIN32
+    if (dados) UnmapViewOfFile(dados);
+    if (mapeamento) CloseHandle(static_cast<HANDLE>(mapeamento));
+    if (ficheiro) CloseHandle(static_cast<HANDLE>(ficheiro));
+    mapeamento = nullptr;
+    ficheiro = nullptr;
+#else
+    if (dados) munmap(dados, tamanho);
+    if (descritor >= 0) close(descritor);
+    descritor = -1;
+#endif
+    dados = nullptr;
+    tamanho = 0;
+    inicio_frames.clear();
+}
+
+size_t LeitorYUV::tamanhoFrame() const {
+    size_t tamanho_luma = static_cast<size_t>(largura_frame) * altura_frame;
+    size_t tamanho_croma = static_cast<size_t>((largura_frame + 1) / 2) * ((altura_frame + 1) / 2);
+    return tamanho_luma + 2 * tamanho_croma;
+}
+
+/**
+ * Função: abrirY4M
+ * Descrição: Lê o cabeçalho YUV4MPEG2 e indexa a posição de cada frame.
+ * Retorna: true em caso de sucesso, false se o ficheiro não existir ou o formato não for suportado.
+ */
+bool LeitorYUV::abrirY4M(const std::string& caminho) {
+    if (!mapear(caminho)) return false;
+
+    const char assinatura[] = "YUV4MPEG2 ";
+    const unsigned char* fim_cabecalho = static_cast<const unsigned char*>(memchr(dados, '\n', tamanho));
+    if (tamanho < sizeof(assinatura) - 1 || memcmp(dados, assinatura, sizeof(assinatura) - 1) != 0 || !fim_cabecalho) {
+        fechar();
+        return false;
+    }
+
+    // Parâmetros do cabeçalho: W<largura> H<altura> F<num>:<den> C<crominância> X<extensão>...
+    std::string cabecalho(reinterpret_cast<const char*>(dados) + sizeof(assinatura) - 1, reinterpret_cast<const char*>(fim_cabecalho));
+    std::istringstream parametros(cabecalho);
+    std::string parametro;
+    std::string croma = "420jpeg";
+    largura_frame = altura_frame = 0;
+    gama_completa = false;
+    fps_nominal = 0.0;
+
+    while (parametros >> parametro) {
+        switch (parametro[0]) {
+        case 'W': largura_frame = std::atoi(parametro.c_str() + 1); break;
+        case 'H': altura_frame = std::atoi(parametro.c_str() + 1); break;
+        case 'C': croma = parametro.substr(1); break;
+        case 'F': {
+            size_t separador = parametro.find(':');
+            if (separador != std::string::npos) {
+                int numerador = std::atoi(parametro.c_str() + 1);
+                int denominador = std::atoi(parametro.c_str() + separador + 1);
+                if (denominador > 0) fps_nominal = static_cast<double>(numerador) / denominador;
+            }
+            break;
+        }
+        case 'X':
+            if (parametro == "XCOLORRANGE=FULL") gama_completa = true;
+            break;
+        default: break;
+        }
+    }
+
+    // Só 4:2:0 com 8 bits por amostra (C420p10/p12/p16 têm 2 bytes por amostra)
+    bool croma_suportada = croma == "420" || croma == "420jpeg" || croma == "420paldv" || croma == "420mpeg2";
+    if (largura_frame <= 0 || altura_frame <= 0 || !croma_suportada) {
+        fechar();
+        return false;
+    }
+
+    // Cada frame começa por "FRAME" seguido de parâmetros opcionais até ao fim da linha
+    const size_t tamanho_frame = tamanhoFrame();
+    size_t posicao = static_cast<size_t>(fim_cabecalho - dados) + 1;
+    while (posicao + 5 <= tamanho && memcmp(dados + posicao, "FRAME", 5) == 0) {
+        const unsigned char* fim_linha = static_cast<const unsigned char*>(memchr(dados + posicao, '\n', tamanho - posicao));
+        if (!fim_linha) break;
+
+        size_t inicio = static_cast<size_t>(fim_linha - dados) + 1;
+        if (inicio + tamanho_frame > tamanho) break; // Frame truncado
+        inicio_frames.push_back(inicio);
+        posicao = inicio + tamanho_frame;
+    }
+
+    // Sem nenhum frame completo (p.ex. cabeçalho do primeiro frame inválido) não há nada para processar
+    if (inicio_frames.empty()) {
+        fechar();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Função: abrirI420
+ * Descrição: Abre um ficheiro I420 em bruto, em que os frames estão guardados consecutivamente.
+ */
+bool LeitorYUV::abrirI420(const std::string& caminho, int largura, int altura, bool gama_completa_fonte) {
+    if (largura <= 0 || altura <= 0) return false;
+    if (!mapear(caminho)) return false;
+
+    largura_frame = largura;
+    altura_frame = altura;
+    gama_completa = gama_completa_fonte;
+    fps_nominal = 0.0;
+
+    const size_t tamanho_frame = tamanhoFrame();
+    for (size_t inicio = 0; inicio + tamanho_frame <= tamanho; inicio += tamanho_frame) {
+        inicio_frames.push_back(inicio);
+    }
+
+    // Ficheiro menor do que um frame (dimensões erradas)
+    if (inicio_frames.empty()) {
+        fechar();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Função: frame
+ * Descrição: Aponta os planos IVC para os dados do frame no mapeamento.
+ *            Escritas nos planos ficam em páginas privadas e só duram enquanto o ficheiro estiver aberto.
+ */
+bool LeitorYUV::frame(long long indice, IVC& luma, IVC& croma_u, IVC& croma_v) const {
+    if (indice < 0 || indice >= numFrames()) return false;
+
+    const int largura_croma = (largura_frame + 1) / 2;
+    const int altura_croma = (altura_frame + 1) / 2;
+    unsigned char* inicio = dados + inicio_frames[static_cast<size_t>(indice)];
+
+    luma.data = inicio;
+    luma.width = largura_frame;
+    luma.height = altura_frame;
+    luma.channels = 1;
+    luma.levels = 255;
+    luma.bytesperline = largura_frame;
+
+    croma_u.data = inicio + static_cast<size_t>(largura_frame) * altura_frame;
+    croma_u.width = largura_croma;
+    croma_u.height = altura_croma;
+    croma_u.channels = 1;
+    croma_u.levels = 255;
+    croma_u.bytesperline = largura_croma;
+
+    croma_v = croma_u;
+    croma_v.data = croma_u.data + static_cast<size_t>(largura_croma) * altura_croma;
+    return true;
+}
@@ -0,0 +1,69 @@
+﻿#ifndef ENTRADA_YUV_H
+#define ENTRADA_YUV_H
+
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "Header.h"
+}
+
+/**
+ * Classe: LeitorYUV
+ * Descrição: Lê ficheiros Y4M ou I420 em bruto (YUV 4:2:0 planar) através de mapeamento em memória.
+ *            Os planos de cada frame são devolvidos como IVC que apontam diretamente para o
+ *            mapeamento, sem cópias nem conversões de cor.
+ */
+class LeitorYUV {
+public:
+    LeitorYUV() {}
+    ~LeitorYUV();
+    LeitorYUV(const LeitorYUV&) = delete;
+    LeitorYUV& operator=(const LeitorYUV&) = delete;
+
+    /**
+     * Abre um ficheiro YUV4MPEG2 (apenas 4:2:0 de 8 bits). Retorna false se não tiver nenhum frame completo.
+     */
+    bool abrirY4M(const std::string& caminho);
+
+    /**
+     * Abre um ficheiro I420 em bruto, sem cabeçalhos, com as dimensões indicadas.
+     * Retorna false se o ficheiro não tiver nenhum frame completo.
+     */
+    bool abrirI420(const std::string& caminho, int largura, int altura, bool gama_completa);
+
+    void fechar();
+
+    int largura() const { return largura_frame; }
+    int altura() const { return altura_frame; }
+    long long numFrames() const { return static_cast<long long>(inicio_frames.size()); }
+    bool gamaCompleta() const { return gama_completa; }
+    double fps() const { return fps_nominal; }
+
+    /**
+     * Preenche luma, croma_u e croma_v com os planos do frame indicado. Podem ser escritos
+     * (cópia privada na escrita), mas as alterações não chegam ao ficheiro.
+     * Retorna: true em caso de sucesso, false se o índice for inválido.
+     */
+    bool frame(long long indice, IVC& luma, IVC& croma_u, IVC& croma_v) const;
+
+private:
+    bool mapear(const std::string& caminho);
+    size_t tamanhoFrame() const;
+
+    unsigned char* dados = nullptr;      // Mapeamento privado: escrever cria cópias das páginas
+    size_t tamanho = 0;
+#ifdef _WIN32
+    void* ficheiro = nullptr;
+    void* mapeamento = nullptr;
+#else
+    int descritor = -1;
+#endif
+
+    int largura_frame = 0, altura_frame = 0;
+    bool gama_completa = false;
+    double fps_nominal = 0.0;
+    std::vector<size_t> inicio_frames;  // Posição do plano Y de cada frame no ficheiro
+};
+
+#endif // ENTRADA_YUV_H
@@ -0,0 +1,350 @@
+﻿#include "estatisticas_moedas.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+static const long long AMOSTRAS_MINIMAS_ALERTA = 20;
+static const double MARGEM_ALERTA = 0.15;       // Alerta quando a mediana está nos 15% de cada extremo da banda
+static const double MARGEM_FIM_ALERTA = 0.20;   // Histerese para não alternar a cada moeda
+static const double FATOR_ESQUECIMENTO = 0.98;  // Memória efetiva de cerca de 50 moedas
+static const double CIRCULARIDADE_MAXIMA = 1.2; // Contornos discretos podem passar ligeiramente de 1
+static const char* const CABECALHO_FICHEIRO = "VCEST 1";
+
+static void acrescentarWelford(AcumuladorWelford& acumulador, double valor) {
+    acumulador.n++;
+    double delta = valor - acumulador.media;
+    acumulador.media += delta / acumulador.n;
+    acumulador.m2 += delta * (valor - acumulador.media);
+}
+
+/**
+ * Função: juntarWelford
+ * Descrição: Combina dois acumuladores (fórmula de Chan et al. para a variância agrupada).
+ */
+static void juntarWelford(AcumuladorWelford& destino, const AcumuladorWelford& origem) {
+    if (origem.n == 0) return;
+    if (destino.n == 0) {
+        destino = origem;
+        return;
+    }
+
+    long long n = destino.n + origem.n;
+    double delta = origem.media - destino.media;
+    destino.media += delta * origem.n / n;
+    destino.m2 += origem.m2 + delta * delta * (static_cast<double>(destino.n) * origem.n / n);
+    destino.n = n;
+}
+
+static void acrescentarHistograma(HistogramaFixo& histograma, double valor) {
+    if (valor < histograma.minimo) {
+        histograma.abaixo++;
+        return;
+    }
+    if (valor >= histograma.maximo) {
+        histograma.acima++;
+        return;
+    }
+
+    int classe = static_cast<int>((valor - histograma.minimo) / (histograma.maximo - histograma.minimo) * NUM_CLASSES_HISTOGRAMA);
+    if (classe >= NUM_CLASSES_HISTOGRAMA) classe = NUM_CLASSES_HISTOGRAMA - 1;
+    histograma.classes[classe]++;
+}
+
+static void juntarHistograma(HistogramaFixo& destino, const HistogramaFixo& origem) {
+    for (int i = 0; i < NUM_CLASSES_HISTOGRAMA; i++) destino.classes[i] += origem.classes[i];
+    destino.abaixo += origem.abaixo;
+    destino.acima += origem.acima;
+}
+
+double desvioPadrao(const AcumuladorWelford& acumulador) {
+    return (acumulador.n > 1) ? std::sqrt(acumulador.m2 / (acumulador.n - 1)) : 0.0;
+}
+
+long long totalHistograma(const HistogramaFixo& histograma) {
+    long long total = histograma.abaixo + histograma.acima;
+    for (int i = 0; i < NUM_CLASSES_HISTOGRAMA; i++) total += histograma.classes[i];
+    return total;
+}
+
+/**
+ * Função: quantilHistograma
+ * Descrição: Percorre as classes até acumular q do total e interpola dentro da classe.
+ *            Os valores fora do intervalo ficam nos extremos (minimo e maximo).
+ */
+double quantilHistograma(const HistogramaFixo& histograma, double q) {
+    long long total = totalHistograma(histograma);
+    if (total == 0) return 0.0;
+
+    double alvo = q * total;
+    double acumulado = static_cast<double>(histograma.abaixo);
+    if (alvo <= acumulado) return histograma.minimo;
+
+    double largura_classe = (histograma.maximo - histograma.minimo) / NUM_CLASSES_HISTOGRAMA;
+    for (int i = 0; i < NUM_CLASSES_HISTOGRAMA; i++) {
+        long long contagem = histograma.classes[i];
+        if (contagem > 0 && acumulado + contagem >= alvo) {
+            double fracao = (alvo - acumulado) / contagem;
+            return histograma.minimo + (i + fracao) * largura_classe;
+        }
+        acumulado += contagem;
+    }
+    return histograma.maximo;
+}
+
+static void acrescentarHistogramaRecente(HistogramaRecente& recente, const HistogramaFixo& limites, double valor) {
+    for (int i = 0; i < NUM_CLASSES_HISTOGRAMA; i++) recente.classes[i] *= FATOR_ESQUECIMENTO;
+    if (valor < limites.minimo || valor >= limites.maximo) return;
+
+    int classe = static_cast<int>((valor - limites.minimo) / (limites.maximo - limites.minimo) * NUM_CLASSES_HISTOGRAMA);
+    if (classe >= NUM_CLASSES_HISTOGRAMA) classe = NUM_CLASSES_HISTOGRAMA - 1;
+    recente.classes[classe] += 1.0;
+}
+
+double medianaAreaRecente(const EstatisticasTipoMoeda& estatisticas_tipo) {
+    const HistogramaFixo& limites = estatisticas_tipo.histograma_area;
+    const HistogramaRecente& recente = estatisticas_tipo.area_recente;
+
+    double total = 0.0;
+    for (int i = 0; i < NUM_CLASSES_HISTOGRAMA; i++) total += recente.classes[i];
+    if (total <= 0.0) return limites.minimo;
+
+    double alvo = 0.5 * total, acumulado = 0.0;
+    double largura_classe = (limites.maximo - limites.minimo) / NUM_CLASSES_HISTOGRAMA;
+    for (int i = 0; i < NUM_CLASSES_HISTOGRAMA; i++) {
+        double peso = recente.classes[i];
+        if (peso > 0.0 && acumulado + peso >= alvo) {
+            return limites.minimo + (i + (alvo - acumulado) / peso) * largura_classe;
+        }
+        acumulado += peso;
+    }
+    return limites.maximo;
+}
+
+double posicaoNaBanda(const EstatisticasTipoMoeda& estatisticas_tipo, double area) {
+    const HistogramaFixo& histograma = estatisticas_tipo.histograma_area;
+    return (area - histograma.minimo) / (histograma.maximo - histograma.minimo);
+}
+
+/**
+ * Função: atualizarAlerta
+ * Descrição: Atualiza o estado de alerta do tipo.
+ * Retorna: true se o tipo acabou de entrar em alerta.
+ */
+static bool atualizarAlerta(EstatisticasTipoMoeda& estatisticas_tipo) {
+    if (estatisticas_tipo.area.n < AMOSTRAS_MINIMAS_ALERTA) return false;
+
+    double posicao = posicaoNaBanda(estatisticas_tipo, medianaAreaRecente(estatisticas_tipo));
+    if (!estatisticas_tipo.em_alerta && (posicao < MARGEM_ALERTA || posicao > 1.0 - MARGEM_ALERTA)) {
+        estatisticas_tipo.em_alerta = true;
+        return true;
+    }
+    if (estatisticas_tipo.em_alerta && posicao >= MARGEM_FIM_ALERTA && posicao <= 1.0 - MARGEM_FIM_ALERTA) {
+        estatisticas_tipo.em_alerta = false;
+    }
+    return false;
+}
+
+/**
+ * Função: iniciarEstatisticas
+ * Descrição: Coloca tudo a zero; o histograma de área de cada tipo cobre a sua banda.
+ */
+void iniciarEstatisticas(EstatisticasMoedas& estatisticas, const ParametrosContagem& parametros) {
+    estatisticas.nome_video = parametros.nome_video;
+    estatisticas.escala_areas = parametros.escala_areas;
+
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) {
+        EstatisticasTipoMoeda& estatisticas_tipo = estatisticas.por_tipo[i];
+        estatisticas_tipo = EstatisticasTipoMoeda();
+
+        BandaArea banda;
+        if (bandaAreaMoeda(static_cast<TipoMoeda>(i), parametros.nome_video, banda)) {
+            estatisticas_tipo.histograma_area.minimo = banda.minimo;
+            estatisticas_tipo.histograma_area.maximo = banda.maximo;
+        }
+        estatisticas_tipo.histograma_circularidade.minimo = 0.0;
+        estatisticas_tipo.histograma_circularidade.maximo = CIRCULARIDADE_MAXIMA;
+    }
+}
+
+bool registarEstatisticas(EstatisticasMoedas& estatisticas, const EventoContagem& evento) {
+    if (evento.tipo_moeda == MOEDA_DESCONHECIDA) return false;
+
+    EstatisticasTipoMoeda& estatisticas_tipo = estatisticas.por_tipo[evento.tipo_moeda];
+    double area_classificada = evento.area / estatisticas.escala_areas;
+
+    acrescentarWelford(estatisticas_tipo.area, area_classificada);
+    acrescentarWelford(estatisticas_tipo.circularidade, evento.circularidade);
+    acrescentarHistograma(estatisticas_tipo.histograma_area, area_classificada);
+    acrescentarHistogramaRecente(estatisticas_tipo.area_recente, estatisticas_tipo.histograma_area, area_classificada);
+    acrescentarHistograma(estatisticas_tipo.histograma_circularidade, evento.circularidade);
+    return atualizarAlerta(estatisticas_tipo);
+}
+
+static bool mesmasClasses(const HistogramaFixo& a, const HistogramaFixo& b) {
+    return std::fabs(a.minimo - b.minimo) <= 1e-9 * std::fabs(a.minimo) + 1e-12
+        && std::fabs(a.maximo - b.maximo) <= 1e-9 * std::fabs(a.maximo) + 1e-12;
+}
+
+/**
+ * Função: juntarEstatisticas
+ * Descrição: Soma as estatísticas de origem às de destino. Só junta se os histogramas de todos os
+ *            tipos tiverem os mesmos limites (p.ex. um ficheiro anterior a uma alteração das bandas
+ *            é rejeitado), pelo que em caso de erro o destino fica inalterado.
+ */
+bool juntarEstatisticas(EstatisticasMoedas& destino, const EstatisticasMoedas& origem) {
+    if (destino.nome_video != origem.nome_video || std::fabs(destino.escala_areas - origem.escala_areas) > 1e-9) return false;
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) {
+        if (!mesmasClasses(destino.por_tipo[i].histograma_area, origem.por_tipo[i].histograma_area)
+            || !mesmasClasses(destino.por_tipo[i].histograma_circularidade, origem.por_tipo[i].histograma_circularidade)) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) {
+        EstatisticasTipoMoeda& estatisticas_tipo = destino.por_tipo[i];
+        juntarWelford(estatisticas_tipo.area, origem.por_tipo[i].area);
+        juntarWelford(estatisticas_tipo.circularidade, origem.por_tipo[i].circularidade);
+        juntarHistograma(estatisticas_tipo.histograma_area, origem.por_tipo[i].histograma_area);
+        juntarHistograma(estatisticas_tipo.histograma_circularidade, origem.por_tipo[i].histograma_circularidade);
+        for (int c = 0; c < NUM_CLASSES_HISTOGRAMA; c++) estatisticas_tipo.area_recente.classes[c] += origem.por_tipo[i].area_recente.classes[c];
+        atualizarAlerta(estatisticas_tipo);
+    }
+    return true;
+}
+
+/**
+ * Função: avisarDerivaArea
+ * Descrição: Alerta que a mediana recente da área de um tipo se aproximou de um limite da sua banda
+ *            (possível deriva da câmara). Usa fprintf para não alocar no ciclo de frames.
+ */
+void avisarDerivaArea(const EstatisticasMoedas& estatisticas, TipoMoeda tipo_moeda) {
+    const EstatisticasTipoMoeda& estatisticas_tipo = estatisticas.por_tipo[tipo_moeda];
+    double mediana_recente = medianaAreaRecente(estatisticas_tipo);
+    fprintf(stderr, "Alerta: a mediana recente da area das moedas de %s (%.0f) esta a %.0f%% da banda [%.0f, %.0f) (%lld moedas)\n",
+        TIPOS_MOEDA[tipo_moeda], mediana_recente, posicaoNaBanda(estatisticas_tipo, mediana_recente) * 100.0,
+        estatisticas_tipo.histograma_area.minimo, estatisticas_tipo.histograma_area.maximo, estatisticas_tipo.area.n);
+}
+
+static void escreverAcumulador(std::ostream& saida, const AcumuladorWelford& acumulador) {
+    saida << " " << acumulador.n << " " << acumulador.media << " " << acumulador.m2;
+}
+
+static void escreverHistograma(std::ostream& saida, const HistogramaFixo& histograma) {
+    saida << " " << histograma.minimo << " " << histograma.maximo << " " << histograma.abaixo << " " << histograma.acima;
+    for (int i = 0; i < NUM_CLASSES_HISTOGRAMA; i++) saida << " " << histograma.classes[i];
+}
+
+static void escreverHistogramaRecente(std::ostream& saida, const HistogramaRecente& recente) {
+    for (int i = 0; i < NUM_CLASSES_HISTOGRAMA; i++) saida << " " << recente.classes[i];
+}
+
+static bool lerAcumulador(std::istream& entrada, AcumuladorWelford& acumulador) {
+    return static_cast<bool>(entrada >> acumulador.n >> acumulador.media >> acumulador.m2);
+}
+
+static bool lerHistograma(std::istream& entrada, HistogramaFixo& histograma) {
+    if (!(entrada >> histograma.minimo >> histograma.maximo >> histograma.abaixo >> histograma.acima)) return false;
+    for (int i = 0; i < NUM_CLASSES_HISTOGRAMA; i++) {
+        if (!(entrada >> histograma.classes[i])) return false;
+    }
+    return true;
+}
+
+static bool lerHistogramaRecente(std::istream& entrada, HistogramaRecente& recente) {
+    for (int i = 0; i < NUM_CLASSES_HISTOGRAMA; i++) {
+        if (!(entrada >> recente.classes[i])) return false;
+    }
+    return true;
+}
+
+/**
+ * Função: guardarEstatisticas
+ * Descrição: Escreve um resumo por tipo em comentários ('#') seguido do estado completo
+ *            (acumuladores e histogramas), com precisão suficiente para voltar a ser lido.
+ */
+bool guardarEstatisticas(const EstatisticasMoedas& estatisticas, const std::string& caminho) {
+    std::ofstream ficheiro(caminho, std::ios::trunc);
+    if (!ficheiro) return false;
+
+    ficheiro << "# tipo n area_media area_desvio area_p10 area_mediana area_p90 mediana_recente posicao_mediana_recente circularidade_media circularidade_desvio alerta\n";
+    ficheiro << std::fixed << std::setprecision(3);
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) {
+        const EstatisticasTipoMoeda& estatisticas_tipo = estatisticas.por_tipo[i];
+        if (estatisticas_tipo.area.n == 0) continue;
+        ficheiro << "# " << TIPOS_MOEDA[i] << " " << estatisticas_tipo.area.n
+            << " " << estatisticas_tipo.area.media << " " << desvioPadrao(estatisticas_tipo.area)
+            << " " << quantilHistograma(estatisticas_tipo.histograma_area, 0.1)
+            << " " << quantilHistograma(estatisticas_tipo.histograma_area, 0.5)
+            << " " << quantilHistograma(estatisticas_tipo.histograma_area, 0.9)
+            << " " << medianaAreaRecente(estatisticas_tipo)
+            << " " << posicaoNaBanda(estatisticas_tipo, medianaAreaRecente(estatisticas_tipo))
+            << " " << estatisticas_tipo.circularidade.media << " " << desvioPadrao(estatisticas_tipo.circularidade)
+            << " " << (estatisticas_tipo.em_alerta ? 1 : 0) << "\n";
+    }
+
+    ficheiro << std::defaultfloat << std::setprecision(17);
+    ficheiro << CABECALHO_FICHEIRO << "\n";
+    ficheiro << "video " << estatisticas.nome_video << "\n";
+    ficheiro << "escala_areas " << estatisticas.escala_areas << "\n";
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) {
+        const EstatisticasTipoMoeda& estatisticas_tipo = estatisticas.por_tipo[i];
+        ficheiro << "tipo " << TIPOS_MOEDA[i];
+        escreverAcumulador(ficheiro, estatisticas_tipo.area);
+        escreverAcumulador(ficheiro, estatisticas_tipo.circularidade);
+        escreverHistograma(ficheiro, estatisticas_tipo.histograma_area);
+        escreverHistograma(ficheiro, estatisticas_tipo.histograma_circularidade);
+        escreverHistogramaRecente(ficheiro, estatisticas_tipo.area_recente);
+        ficheiro << "\n";
+    }
+    return static_cast<bool>(ficheiro);
+}
+
+bool carregarEstatisticas(EstatisticasMoedas& estatisticas, const std::string& caminho) {
+    std::ifstream ficheiro(caminho);
+    if (!ficheiro) return false;
+
+    EstatisticasMoedas lidas;
+    bool cabecalho_lido = false;
+    int tipos_lidos = 0;
+    std::string linha;
+
+    while (std::getline(ficheiro, linha)) {
+        if (!linha.empty() && linha.back() == '\r') linha.pop_back();
+        if (linha.empty() || linha[0] == '#') continue;
+
+        if (!cabecalho_lido) {
+            if (linha != CABECALHO_FICHEIRO) return false;
+            cabecalho_lido = true;
+        }
+        else if (linha.compare(0, 6, "video ") == 0) {
+            lidas.nome_video = linha.substr(6);
+        }
+        else if (linha.compare(0, 13, "escala_areas ") == 0) {
+            lidas.escala_areas = std::atof(linha.c_str() + 13);
+        }
+        else if (linha.compare(0, 5, "tipo ") == 0) {
+            std::istringstream campos(linha.substr(5));
+            std::string nome_tipo;
+            campos >> nome_tipo;
+            TipoMoeda tipo = tipoMoedaDeTexto(nome_tipo);
+            if (tipo == MOEDA_DESCONHECIDA) return false;
+
+            EstatisticasTipoMoeda& estatisticas_tipo = lidas.por_tipo[tipo];
+            if (!lerAcumulador(campos, estatisticas_tipo.area) || !lerAcumulador(campos, estatisticas_tipo.circularidade)
+                || !lerHistograma(campos, estatisticas_tipo.histograma_area) || !lerHistograma(campos, estatisticas_tipo.histograma_circularidade)
+                || !lerHistogramaRecente(campos, estatisticas_tipo.area_recente)) {
+                return false;
+            }
+            tipos_lidos++;
+        }
+        else {
+            return false;
+        }
+    }
+
+    if (!cabecalho_lido || tipos_lidos != NUM_TIPOS_MOEDA) return false;
+    return juntarEstatisticas(estatisticas, lidas);
+}
@@ -0,0 +1,123 @@
+﻿#ifndef ESTATISTICAS_MOEDAS_H
+#define ESTATISTICAS_MOEDAS_H
+
+#include "contagem.h"
+#include <string>
+
+// Classes dos histogramas de área e de circularidade
+const int NUM_CLASSES_HISTOGRAMA = 64;
+
+/**
+ * Estrutura: AcumuladorWelford
+ * Descrição: Média e variância incrementais (algoritmo de Welford).
+ */
+struct AcumuladorWelford {
+    long long n = 0;
+    double media = 0.0;
+    double m2 = 0.0;                // Soma dos quadrados dos desvios à média
+};
+
+/**
+ * Estrutura: HistogramaFixo
+ * Descrição: Histograma de classes iguais em [minimo, maximo); os valores fora do intervalo
+ *            são contados à parte.
+ */
+struct HistogramaFixo {
+    double minimo = 0.0;
+    double maximo = 1.0;
+    long long classes[NUM_CLASSES_HISTOGRAMA] = {};
+    long long abaixo = 0;
+    long long acima = 0;
+};
+
+/**
+ * Estrutura: HistogramaRecente
+ * Descrição: Histograma com esquecimento exponencial: a cada valor novo os pesos anteriores são
+ *            multiplicados por um fator < 1, pelo que a mediana reflete as últimas dezenas de moedas
+ *            e acompanha uma deriva que a distribuição do turno inteiro demoraria a mostrar.
+ */
+struct HistogramaRecente {
+    double classes[NUM_CLASSES_HISTOGRAMA] = {};
+};
+
+/**
+ * Estrutura: EstatisticasTipoMoeda
+ * Descrição: Distribuição da área e da circularidade das moedas contadas de um tipo.
+ *            A área é a usada na classificação (dividida por escala_areas), pelo que o
+ *            histograma de área cobre exatamente a banda do tipo.
+ */
+struct EstatisticasTipoMoeda {
+    AcumuladorWelford area;
+    AcumuladorWelford circularidade;
+    HistogramaFixo histograma_area;
+    HistogramaFixo histograma_circularidade;
+    HistogramaRecente area_recente;     // Mesmas classes que histograma_area
+    bool em_alerta = false;         // Mediana recente da área perto de um dos limites da banda
+};
+
+/**
+ * Estrutura: EstatisticasMoedas
+ * Descrição: Estatísticas de memória constante por tipo de moeda. Podem ser juntadas entre
+ *            threads (segmentos) e entre sessões (ficheiro exportado no fim); ao juntar, os
+ *            histogramas recentes são somados, o que é uma aproximação.
+ */
+struct EstatisticasMoedas {
+    std::string nome_video;         // As bandas dependem das regras do vídeo
+    double escala_areas = 1.0;
+    EstatisticasTipoMoeda por_tipo[NUM_TIPOS_MOEDA];
+};
+
+/**
+ * Coloca as estatísticas a zero e ajusta os histogramas de área às bandas do vídeo.
+ */
+void iniciarEstatisticas(EstatisticasMoedas& estatisticas, const ParametrosContagem& parametros);
+
+/**
+ * Acrescenta uma moeda contada. Moedas desconhecidas são ignoradas.
+ * Retorna: true se o tipo da moeda acabou de entrar em alerta de deriva.
+ */
+bool registarEstatisticas(EstatisticasMoedas& estatisticas, const EventoContagem& evento);
+
+/**
+ * Junta as estatísticas de origem às de destino.
+ * Retorna: false se tiverem sido obtidas com regras diferentes (vídeo, escala de áreas ou
+ *          limites dos histogramas, que acompanham as bandas de classificação).
+ */
+bool juntarEstatisticas(EstatisticasMoedas& destino, const EstatisticasMoedas& origem);
+
+/**
+ * Escreve em stderr o alerta de deriva de um tipo (chamar quando registarEstatisticas devolve true).
+ */
+void avisarDerivaArea(const EstatisticasMoedas& estatisticas, TipoMoeda tipo_moeda);
+
+double desvioPadrao(const AcumuladorWelford& acumulador);
+long long totalHistograma(const HistogramaFixo& histograma);
+
+/**
+ * Estima o quantil q (0 a 1) por interpolação linear dentro da classe.
+ */
+double quantilHistograma(const HistogramaFixo& histograma, double q);
+
+/**
+ * Mediana da área das moedas recentes (histograma com esquecimento).
+ */
+double medianaAreaRecente(const EstatisticasTipoMoeda& estatisticas_tipo);
+
+/**
+ * Posição de uma área na banda do tipo: 0 no limite inferior, 1 no superior.
+ */
+double posicaoNaBanda(const EstatisticasTipoMoeda& estatisticas_tipo, double area);
+
+/**
+ * Escreve as estatísticas num ficheiro de texto (com um resumo legível em comentários)
+ * que pode ser lido por carregarEstatisticas.
+ */
+bool guardarEstatisticas(const EstatisticasMoedas& estatisticas, const std::string& caminho);
+
+/**
+ * Lê um ficheiro escrito por guardarEstatisticas e junta-o às estatísticas indicadas.
+ * Retorna: false se o ficheiro não puder ser lido ou for de outras regras.
+ */
+bool carregarEstatisticas(EstatisticasMoedas& estatisticas, const std::string& caminho);
+
+#endif // ESTATISTICAS_MOEDAS_H
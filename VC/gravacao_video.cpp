@@ -0,0 +1,143 @@
+﻿#include "gravacao_video.h"
+#include <algorithm>
+#include <chrono>
+
+/**
+ * Função: GravadorVideoAnotado (construtor)
+ * Descrição: Guarda a política; os buffers só são criados em abrir(), quando se conhecem as dimensões.
+ */
+GravadorVideoAnotado::GravadorVideoAnotado(PoliticaGravacao politica, int num_buffers)
+    : politica(politica), buffers(num_buffers < 2 ? 2 : num_buffers) {
+}
+
+GravadorVideoAnotado::~GravadorVideoAnotado() {
+    fechar();
+}
+
+/**
+ * Função: abrir
+ * Descrição: Abre o cv::VideoWriter, aloca os buffers e arranca a thread de codificação.
+ * Retorna: true em caso de sucesso, false se o ficheiro não puder ser criado.
+ */
+bool GravadorVideoAnotado::abrir(const std::string& caminho, int largura, int altura, double fps) {
+    bool avi = caminho.size() >= 4 && caminho.compare(caminho.size() - 4, 4, ".avi") == 0;
+    int fourcc = avi ? cv::VideoWriter::fourcc('M', 'J', 'P', 'G') : cv::VideoWriter::fourcc('m', 'p', '4', 'v');
+    if (!escritor.open(caminho, fourcc, fps > 0.0 ? fps : 30.0, cv::Size(largura, altura), true)) return false;
+
+    int num_buffers = static_cast<int>(buffers.size());
+    pendentes.assign(num_buffers, -1);
+    livres.clear();
+    livres.reserve(num_buffers);
+    for (int i = 0; i < num_buffers; i++) {
+        buffers[i].create(altura, largura, CV_8UC3);
+        livres.push_back(i);
+    }
+
+    a_terminar = false;
+    thread_escrita = std::thread(&GravadorVideoAnotado::cicloEscrita, this);
+    return true;
+}
+
+/**
+ * Função: gravarFrame
+ * Descrição: Copia o frame para um buffer livre e coloca-o na fila. Sem buffers livres o codificador
+ *            está atrasado, e aplica-se a política: descartar o frame novo, reutilizar o buffer do
+ *            frame pendente mais antigo, ou esperar.
+ */
+void GravadorVideoAnotado::gravarFrame(const cv::Mat& frame) {
+    if (!aberto()) return;
+
+    std::unique_lock<std::mutex> lock(mutex_buffers);
+    stats.frames_recebidos++;
+
+    int indice_buffer;
+    if (!livres.empty()) {
+        indice_buffer = livres.back();
+        livres.pop_back();
+    }
+    else {
+        stats.vezes_em_atraso++;
+
+        if (politica == GRAVACAO_DESCARTAR_NOVO || (politica == GRAVACAO_DESCARTAR_ANTIGO && num_pendentes == 0)) {
+            // Sem pendentes, todos os buffers estão a ser codificados: nada para substituir
+            stats.frames_descartados++;
+            return;
+        }
+        else if (politica == GRAVACAO_DESCARTAR_ANTIGO) {
+            indice_buffer = pendentes[inicio_pendentes];
+            inicio_pendentes = (inicio_pendentes + 1) % static_cast<int>(pendentes.size());
+            num_pendentes--;
+            stats.frames_descartados++;
+        }
+        else {
+            auto inicio_espera = std::chrono::steady_clock::now();
+            buffer_livre.wait(lock, [this] { return !livres.empty(); });
+            stats.espera_total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio_espera).count();
+            indice_buffer = livres.back();
+            livres.pop_back();
+        }
+    }
+
+    // O buffer não está em nenhuma lista enquanto é preenchido, pelo que a cópia pode ser feita sem o mutex
+    lock.unlock();
+    frame.copyTo(buffers[indice_buffer]);
+    lock.lock();
+
+    pendentes[(inicio_pendentes + num_pendentes) % static_cast<int>(pendentes.size())] = indice_buffer;
+    num_pendentes++;
+    stats.ocupacao_maxima = std::max(stats.ocupacao_maxima, num_pendentes);
+    lock.unlock();
+    frame_pendente.notify_one();
+}
+
+/**
+ * Função: cicloEscrita
+ * Descrição: Thread de codificação. Grava os buffers pendentes por ordem e devolve-os à lista de livres.
+ */
+void GravadorVideoAnotado::cicloEscrita() {
+    while (true) {
+        int indice_buffer;
+        {
+            std::unique_lock<std::mutex> lock(mutex_buffers);
+            frame_pendente.wait(lock, [this] { return num_pendentes > 0 || a_terminar; });
+            if (num_pendentes == 0) return;     // a_terminar e fila vazia
+
+            indice_buffer = pendentes[inicio_pendentes];
+            inicio_pendentes = (inicio_pendentes + 1) % static_cast<int>(pendentes.size());
+            num_pendentes--;
+        }
+
+        escritor.write(buffers[indice_buffer]);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_buffers);
+            livres.push_back(indice_buffer);
+            stats.frames_gravados++;
+        }
+        buffer_livre.notify_one();
+    }
+}
+
+void GravadorVideoAnotado::fechar() {
+    if (!thread_escrita.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_buffers);
+        a_terminar = true;
+    }
+    frame_pendente.notify_all();
+    thread_escrita.join();
+    escritor.release();
+}
+
+EstatisticasGravacao GravadorVideoAnotado::estatisticas() const {
+    std::lock_guard<std::mutex> lock(mutex_buffers);
+    return stats;
+}
+
+bool politicaGravacaoDeTexto(const std::string& texto, PoliticaGravacao& politica) {
+    if (texto == "novo") politica = GRAVACAO_DESCARTAR_NOVO;
+    else if (texto == "antigo") politica = GRAVACAO_DESCARTAR_ANTIGO;
+    else if (texto == "bloquear") politica = GRAVACAO_BLOQUEAR;
+    else return false;
+    return true;
+}
@@ -0,0 +1,93 @@
+﻿#ifndef GRAVACAO_VIDEO_H
+#define GRAVACAO_VIDEO_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Enumeração: PoliticaGravacao
+ * Descrição: Define o que fazer quando o codificador está atrasado e não há buffers livres.
+ */
+enum PoliticaGravacao {
+    GRAVACAO_DESCARTAR_NOVO,        // Não grava o frame novo (o ciclo de frames nunca espera)
+    GRAVACAO_DESCARTAR_ANTIGO,      // Substitui o frame pendente mais antigo (o ciclo nunca espera)
+    GRAVACAO_BLOQUEAR               // Espera por um buffer livre (todos os frames são gravados)
+};
+
+/**
+ * Estrutura: EstatisticasGravacao
+ * Descrição: Contadores da gravação do vídeo anotado.
+ */
+struct EstatisticasGravacao {
+    long long frames_recebidos = 0;
+    long long frames_gravados = 0;
+    long long frames_descartados = 0;
+    long long vezes_em_atraso = 0;      // Frames que chegaram sem nenhum buffer livre
+    double espera_total_ms = 0.0;       // Tempo em que o ciclo de frames esteve bloqueado (GRAVACAO_BLOQUEAR)
+    int ocupacao_maxima = 0;            // Máximo de frames pendentes na fila
+};
+
+/**
+ * Classe: GravadorVideoAnotado
+ * Descrição: Grava os frames anotados num ficheiro de vídeo numa thread própria. Os frames são
+ *            copiados para um conjunto fixo de buffers reciclados, pelo que a gravação não faz
+ *            alocações por frame e a codificação não atrasa o ciclo de frames.
+ */
+class GravadorVideoAnotado {
+public:
+    GravadorVideoAnotado(PoliticaGravacao politica, int num_buffers);
+    ~GravadorVideoAnotado();
+    GravadorVideoAnotado(const GravadorVideoAnotado&) = delete;
+    GravadorVideoAnotado& operator=(const GravadorVideoAnotado&) = delete;
+
+    /**
+     * Cria o ficheiro (MJPG para .avi, mp4v nos restantes) e arranca a thread de codificação.
+     */
+    bool abrir(const std::string& caminho, int largura, int altura, double fps);
+
+    /**
+     * Entrega um frame BGR com as dimensões indicadas em abrir() (é copiado).
+     */
+    void gravarFrame(const cv::Mat& frame);
+
+    /**
+     * Grava os frames pendentes e fecha o ficheiro.
+     */
+    void fechar();
+
+    bool aberto() const { return thread_escrita.joinable(); }
+    EstatisticasGravacao estatisticas() const;
+
+private:
+    void cicloEscrita();
+
+    PoliticaGravacao politica;
+    cv::VideoWriter escritor;
+    std::vector<cv::Mat> buffers;
+
+    // Fila circular de índices de buffers pendentes e pilha de índices livres
+    std::vector<int> pendentes;
+    int inicio_pendentes = 0, num_pendentes = 0;
+    std::vector<int> livres;
+
+    std::thread thread_escrita;
+    mutable std::mutex mutex_buffers;
+    std::condition_variable frame_pendente;
+    std::condition_variable buffer_livre;
+    bool a_terminar = false;
+
+    EstatisticasGravacao stats;
+};
+
+/**
+ * Função: politicaGravacaoDeTexto
+ * Descrição: Converte "novo", "antigo" ou "bloquear" na política correspondente.
+ */
+bool politicaGravacaoDeTexto(const std::string& texto, PoliticaGravacao& politica);
+
+#endif // GRAVACAO_VIDEO_H
@@ -6,10 +6,20 @@
 #include <cmath>
 #include <chrono>
 #include <iomanip>
-
-extern "C" {
-#include "Header.h" 
-}
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "alocacoes.h"
+#include "contagem.h"
+#include "entrada_yuv.h"
+#include "estatisticas_moedas.h"
+#include "gravacao_video.h"
+#include "metricas.h"
+#include "segmentos.h"
+#include "tempo_real.h"
+#include "traco_blobs.h"
+#include "varrimento.h"
 
 /**
  * Função: tempoDecorrido
@@ -32,292 +42,623 @@ void tempoDecorrido() {
 }
 
 /**
- * Função: identificarTipoMoeda
- * Descrição: Identifica o tipo de moeda.
+ * Função: desenharResultados
+ * Descrição: Desenha a linha de contagem, os blobs, os tipos de moeda e o painel de totais no frame.
+ *            Os textos são formatados num buffer fixo e copiados para sessao.texto, que mantém a
+ *            capacidade entre frames.
  */
-std::string identificarTipoMoeda(double area, const std::string& nome_video) {
-    std::string tipo_moeda = "Desconhecida";
-
-    // Regras de área para o video1.mp4
-    if (nome_video == "video1.mp4") {
-        if (area >= 10600 && area < 11400) tipo_moeda = "1c";
-        else if (area >= 13800 && area < 14850) tipo_moeda = "2c";
-        else if (area >= 17800 && area < 18900) tipo_moeda = "5c";
-        else if (area >= 14800 && area < 15800) tipo_moeda = "10c";
-        else if (area >= 18500 && area < 20000) tipo_moeda = "20c";
-        else if (area >= 23300 && area < 24300) tipo_moeda = "50c";
-        else if (area >= 20500 && area < 22300) tipo_moeda = "1euro";
-        else if (area >= 26200 && area < 27300) tipo_moeda = "2euro";
-    }
-    // Regras de área para o video2.mp4
-    else if (nome_video == "video2.mp4") {
-        if (area >= 10000 && area < 12100) tipo_moeda = "1c";
-        else if (area >= 13400 && area < 15090) tipo_moeda = "2c";
-        else if (area >= 17100 && area < 19500) tipo_moeda = "5c";
-        else if (area >= 15100 && area < 17000) tipo_moeda = "10c";
-        else if (area >= 19600 && area < 21900) tipo_moeda = "20c";
-        else if (area >= 23700 && area < 26000) tipo_moeda = "50c";
-        else if (area >= 22000 && area < 23600) tipo_moeda = "1euro";
-        else if (area >= 27000 && area < 28200) tipo_moeda = "2euro";
-    }
-
-    return tipo_moeda;
+void desenharResultados(cv::Mat& frame_original, SessaoContagem& sessao, const std::string& nome_video) {
+    IVC* img_cor = sessao.imagens.cor;
+    int largura = img_cor->width, altura = img_cor->height;
+    char buffer[64];
+
+    // PAINEL DOS RESULTADOS
+    vc_desenha_linha_horizontal(img_cor, sessao.tracking.linha_de_contagem_y, 255, 0, 0);
+
+    for (const auto& blob : sessao.blobs) {
+        vc_desenha_caixa_delimitadora(img_cor, (OVC*)&blob.info);
+        vc_desenha_centro_massa(img_cor, (OVC*)&blob.info, 5);
+    }
+
+    // Na segmentação em linhas img_cor já é uma vista sobre o próprio frame
+    if (img_cor->data != frame_original.data) memcpy(frame_original.data, img_cor->data, largura * altura * 3);
+
+    // DESENHAR O TEXTO DAS MOEDAS (COM CIRCULARIDADE)
+    for (const auto& blob : sessao.blobs) {
+        OVC blob_info = blob.info;
+        TipoMoeda tipo_moeda = identificarTipoMoeda(blob.area, nome_video);
+
+        if (tipo_moeda != MOEDA_DESCONHECIDA) {
+            int x_pos = blob_info.x;
+            int y_pos = blob_info.y - 10;
+            if (y_pos < 10) y_pos = blob_info.y + blob_info.height + 20;
+
+            // Cria o texto final, com a circularidade com 2 casas decimais
+            snprintf(buffer, sizeof(buffer), "%s (C:%.2f)", nomeTipoMoeda(tipo_moeda), blob.circularidade);
+            sessao.texto.assign(buffer);
+
+            cv::putText(frame_original, sessao.texto, cv::Point(x_pos, y_pos), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 0), 2);
+            cv::putText(frame_original, sessao.texto, cv::Point(x_pos, y_pos), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 0), 1);
+        }
+    }
+
+    // Desenha o painel de informações
+    int pos_y_painel = 30;
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) {
+        snprintf(buffer, sizeof(buffer), "%s: %d", TIPOS_MOEDA[i], sessao.totais.contagem_por_tipo[i]);
+        sessao.texto.assign(buffer);
+        cv::putText(frame_original, sessao.texto, cv::Point(20, pos_y_painel), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 0), 2);
+        cv::putText(frame_original, sessao.texto, cv::Point(20, pos_y_painel), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 255), 1);
+        pos_y_painel += 25;
+    }
+    snprintf(buffer, sizeof(buffer), "Total: %.2f EUR", sessao.totais.valor_total_euros);
+    sessao.texto.assign(buffer);
+    cv::putText(frame_original, sessao.texto, cv::Point(20, pos_y_painel + 10), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 0, 0), 2);
+    cv::putText(frame_original, sessao.texto, cv::Point(20, pos_y_painel + 10), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 1);
+}
+
+/**
+ * Função: mostrarContagemFinal
+ * Descrição: Mostra os totais finais na consola.
+ */
+void mostrarContagemFinal(const TotaisContagem& totais) {
+    std::cout << "\n=== Contagem Final ===\n";
+    std::cout << "Total de moedas contadas: " << totais.total_moedas_contadas << "\n";
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) {
+        std::cout << " - Moedas de " << TIPOS_MOEDA[i] << ": " << totais.contagem_por_tipo[i] << "\n";
+    }
+    std::cout << "Valor Total Acumulado: " << std::fixed << std::setprecision(2) << totais.valor_total_euros << " EUR\n";
 }
 
 /**
- * Função: calcularPropriedadesBlob
- * Descrição: Calcula a caixa delimitadora e o centroide de um contorno.
+ * Função: mostrarEstatisticasTempoReal
+ * Descrição: Mostra as métricas de sobrecarga e lag do modo em tempo real.
  */
-void calcularPropriedadesBlob(const std::vector<cv::Point>& contorno, OVC& info_blob) {
-    if (contorno.empty()) return;
-
-    int min_x = contorno[0].x, max_x = contorno[0].x;
-    int min_y = contorno[0].y, max_y = contorno[0].y;
-    long long soma_x = 0, soma_y = 0;
-
-    for (const auto& ponto : contorno) {
-        soma_x += ponto.x;
-        soma_y += ponto.y;
-        if (ponto.x < min_x) min_x = ponto.x;
-        if (ponto.x > max_x) max_x = ponto.x;
-        if (ponto.y < min_y) min_y = ponto.y;
-        if (ponto.y > max_y) max_y = ponto.y;
-    }
-
-    info_blob.x = min_x;
-    info_blob.y = min_y;
-    info_blob.width = max_x - min_x + 1;
-    info_blob.height = max_y - min_y + 1;
-    info_blob.xc = static_cast<int>(soma_x / contorno.size());
-    info_blob.yc = static_cast<int>(soma_y / contorno.size());
+void mostrarEstatisticasTempoReal(const EstatisticasTempoReal& stats, double orcamento_latencia_ms) {
+    std::cout << "\n=== Tempo Real ===\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Intervalo entre frames da fonte: " << stats.intervalo_frame_ms << " ms\n";
+    std::cout << "Processamento medio por frame: " << stats.processamento_medio_ms << " ms\n";
+    std::cout << "Frames capturados: " << stats.frames_capturados << "\n";
+    std::cout << "Frames processados: " << stats.frames_processados << "\n";
+    std::cout << "Frames descartados: " << stats.frames_descartados << "\n";
+    std::cout << "Lag medio / p99 / maximo: " << stats.lag_medio_ms << " / " << stats.lag_p99_ms << " / " << stats.lag_maximo_ms << " ms\n";
+    std::cout << "Frames acima do orcamento (" << orcamento_latencia_ms << " ms): " << stats.frames_acima_orcamento << "\n";
+    std::cout << "Fator de dizimacao final: " << stats.fator_dizimacao << "\n";
+    std::cout << "Frames com fator de dizimacao limitado pelo tracking: " << stats.frames_fator_limitado << "\n";
 }
 
+/**
+ * Função: mostrarEstatisticasMoedas
+ * Descrição: Mostra, por tipo, a distribuição da área e da circularidade das moedas contadas.
+ */
+void mostrarEstatisticasMoedas(const EstatisticasMoedas& estatisticas) {
+    std::cout << "\n=== Estatisticas por Tipo de Moeda ===\n";
+    std::cout << std::fixed;
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) {
+        const EstatisticasTipoMoeda& estatisticas_tipo = estatisticas.por_tipo[i];
+        if (estatisticas_tipo.area.n == 0) continue;
+
+        std::cout << " - " << TIPOS_MOEDA[i] << ": " << estatisticas_tipo.area.n << " moedas | Area: "
+            << std::setprecision(0) << estatisticas_tipo.area.media << " +/- " << desvioPadrao(estatisticas_tipo.area)
+            << " (mediana " << quantilHistograma(estatisticas_tipo.histograma_area, 0.5)
+            << ", recente " << medianaAreaRecente(estatisticas_tipo)
+            << " a " << posicaoNaBanda(estatisticas_tipo, medianaAreaRecente(estatisticas_tipo)) * 100.0 << "% da banda)"
+            << " | Circularidade: " << std::setprecision(2) << estatisticas_tipo.circularidade.media
+            << " +/- " << desvioPadrao(estatisticas_tipo.circularidade)
+            << (estatisticas_tipo.em_alerta ? " | ALERTA: mediana recente perto do limite da banda" : "") << "\n";
+    }
+}
 
+/**
+ * Função: exportarEstatisticasMoedas
+ * Descrição: Mostra as estatísticas por tipo e, se pedido, grava-as no ficheiro.
+ * Retorna: false se o ficheiro não puder ser escrito.
+ */
+bool exportarEstatisticasMoedas(const EstatisticasMoedas& estatisticas, const std::string& ficheiro_estatisticas) {
+    mostrarEstatisticasMoedas(estatisticas);
+    if (ficheiro_estatisticas.empty()) return true;
 
+    if (!guardarEstatisticas(estatisticas, ficheiro_estatisticas)) {
+        std::cerr << "Erro: Nao foi possivel escrever o ficheiro de estatisticas.\n";
+        return false;
+    }
+    return true;
+}
 
-// Função para calcular o perímetro de um contorno
-double calcularPerimetro(const std::vector<cv::Point>& contorno) {
-    double perimetro = 0.0;
-    if (contorno.size() < 2) return 0.0;
+/**
+ * Função: mostrarEstatisticasGravacao
+ * Descrição: Mostra quantos frames anotados foram gravados e quantas vezes o codificador se atrasou.
+ */
+void mostrarEstatisticasGravacao(const EstatisticasGravacao& stats) {
+    std::cout << "\n=== Gravacao do Video Anotado ===\n";
+    std::cout << "Frames recebidos / gravados / descartados: " << stats.frames_recebidos << " / " << stats.frames_gravados
+        << " / " << stats.frames_descartados << "\n";
+    std::cout << "Codificador em atraso: " << stats.vezes_em_atraso << " frames";
+    std::cout << " | Espera total: " << std::fixed << std::setprecision(1) << stats.espera_total_ms << " ms";
+    std::cout << " | Ocupacao maxima da fila: " << stats.ocupacao_maxima << "\n";
+}
 
-    for (size_t i = 0; i < contorno.size(); ++i) {
-        // Ponto atual
-        cv::Point p1 = contorno[i];
-        // Próximo ponto (o operador % garante que o último ponto é ligado ao primeiro)
-        cv::Point p2 = contorno[(i + 1) % contorno.size()];
+/**
+ * Função: mostrarResultadoVarrimento
+ * Descrição: Mostra a contagem, a exatidão e o tempo de cada configuração do varrimento.
+ */
+void mostrarResultadoVarrimento(const ResultadoVarrimento& resultado) {
+    std::cout << "\n=== Varrimento de Parametros ===\n";
+    std::cout << std::fixed;
+    for (size_t i = 0; i < resultado.configuracoes.size(); i++) {
+        const ConfiguracaoVarrimento& configuracao = resultado.configuracoes[i];
+        std::cout << "[" << i + 1 << "] " << configuracao.descricao << "\n";
+        std::cout << "    Moedas: " << configuracao.totais.total_moedas_contadas
+            << " | Valor: " << std::setprecision(2) << configuracao.totais.valor_total_euros << " EUR |";
+        for (int t = 0; t < NUM_TIPOS_MOEDA; t++) {
+            std::cout << " " << TIPOS_MOEDA[t] << "=" << configuracao.totais.contagem_por_tipo[t];
+        }
+        std::cout << "\n";
+        if (resultado.com_referencia) {
+            std::cout << "    Erro: " << configuracao.erro_absoluto << " | Exatidao: " << std::setprecision(1) << configuracao.exatidao * 100.0 << " %";
+        }
+        else {
+            std::cout << "   ";
+        }
+        if (resultado.frames > 0) {
+            std::cout << " | Processamento: " << std::setprecision(2) << configuracao.segundos_processamento * 1000.0 / resultado.frames << " ms/frame";
+        }
+        std::cout << "\n";
+    }
 
-        // Usa std::hypot para maior precisão e segurança numérica
-        perimetro += std::hypot(p2.x - p1.x, p2.y - p1.y);
+    if (resultado.com_referencia) {
+        size_t melhor = 0;
+        for (size_t i = 1; i < resultado.configuracoes.size(); i++) {
+            if (resultado.configuracoes[i].erro_absoluto < resultado.configuracoes[melhor].erro_absoluto) melhor = i;
+        }
+        std::cout << "Melhor configuracao: [" << melhor + 1 << "] " << resultado.configuracoes[melhor].descricao << "\n";
     }
 
-    return perimetro;
+    std::cout << "Frames: " << resultado.frames << " | Configuracoes: " << resultado.configuracoes.size() << " | Threads: " << resultado.num_threads << "\n";
+    std::cout << "Tempo: " << std::setprecision(2) << resultado.segundos << " segundos (descodificacao: " << resultado.segundos_descodificacao << " s)";
+    if (resultado.segundos > 0.0) {
+        std::cout << " | " << std::setprecision(1) << resultado.frames / resultado.segundos << " fps | "
+            << resultado.frames * resultado.configuracoes.size() / resultado.segundos << " frames-configuracao/s";
+    }
+    std::cout << "\n";
 }
 
+/**
+ * Função: processarFonteYUV
+ * Descrição: Processa uma captura YUV mapeada em memória (sem janelas). O plano Y entra
+ *            diretamente na binarização e a crominância só é lida no filtro de cor dos blobs.
+ * Retorna: 0 em caso de sucesso, 1 em caso de erro.
+ */
+int processarFonteYUV(const LeitorYUV& leitor, const ParametrosContagem& parametros, MetricasPipeline& metricas, GravadorTraco& gravador_traco,
+    EstatisticasMoedas& estatisticas) {
+    SessaoContagem sessao;
+    if (!iniciarSessaoContagem(sessao, leitor.largura(), leitor.altura(), parametros, false)) {
+        std::cerr << "Erro: Nao foi possivel alocar as imagens de trabalho.\n";
+        return 1;
+    }
 
+    VerificadorAlocacoesFrame verificador_alocacoes;
+    IVC luma, croma_u, croma_v;
+    bool traco_gravado = true;
+
+    auto inicio = std::chrono::steady_clock::now();
+    for (long long indice_frame = 0; indice_frame < leitor.numFrames(); indice_frame++) {
+        verificador_alocacoes.iniciarFrame();
+        leitor.frame(indice_frame, luma, croma_u, croma_v);
+
+        auto t0 = std::chrono::steady_clock::now();
+        segmentarMoedasLuma(&luma, &croma_u, &croma_v, leitor.gamaCompleta(), sessao.imagens, parametros);
+        auto t1 = std::chrono::steady_clock::now();
+        extrairBlobsValidos(sessao.imagens, parametros, sessao.blobs);
+        auto t2 = std::chrono::steady_clock::now();
+        if (gravador_traco.aberto() && !gravador_traco.gravarFrame(indice_frame, sessao.blobs)) {
+            traco_gravado = false;
+            break;
+        }
 
+        sessao.eventos.clear();
+        atualizarTracking(sessao.tracking, sessao.blobs, parametros, 1, indice_frame, sessao.eventos);
+        for (const auto& evento : sessao.eventos) {
+            registarContagem(sessao.totais, evento);
+            metricas.registarContagem(evento);
+            if (registarEstatisticas(estatisticas, evento)) avisarDerivaArea(estatisticas, evento.tipo_moeda);
+        }
+        auto t3 = std::chrono::steady_clock::now();
+
+        metricas.registarEtapa(ETAPA_SEGMENTACAO, t1 - t0);
+        metricas.registarEtapa(ETAPA_BLOBS, t2 - t1);
+        metricas.registarEtapa(ETAPA_TRACKING, t3 - t2);
+        metricas.definirObjetosRastreados(static_cast<long long>(sessao.tracking.objetos_rastreados.size()));
+        metricas.registarFrame();
+        verificador_alocacoes.terminarFrame();
+    }
+    double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+
+    terminarSessaoContagem(sessao);
+    if (!gravador_traco.fechar() || !traco_gravado) {
+        std::cerr << "Erro: Nao foi possivel escrever o ficheiro de traco.\n";
+        return 1;
+    }
+    mostrarContagemFinal(sessao.totais);
+    std::cout << "Frames: " << leitor.numFrames() << " | Tempo: " << std::setprecision(2) << segundos << " segundos";
+    if (segundos > 0.0) std::cout << " | " << std::setprecision(1) << leitor.numFrames() / segundos << " fps";
+    std::cout << "\n";
+    return 0;
+}
 
 /**
  * Função principal (main)
+ * Argumentos opcionais:
+ *   --video <nome>            vídeo a processar (define também as regras de classificação)
+ *   --tempo-real <fonte>      modo em tempo real; fonte é um índice de câmara ou um ficheiro
+ *   --politica <p>            política de sobrecarga: antigo, recente ou dizimar
+ *   --orcamento-ms <ms>       orçamento de latência para as métricas de lag
+ *   --segmentos <n>           processa o vídeo em n segmentos paralelos (0 = número de núcleos)
+ *   --y4m <ficheiro>          processa uma captura Y4M (4:2:0) mapeada em memória
+ *   --i420 <ficheiro>         processa uma captura I420 em bruto (requer --dimensoes)
+ *   --dimensoes <LxA>         dimensões dos frames I420, por exemplo 1920x1080
+ *   --gama-completa           a luma I420 usa a gama 0-255 em vez de 16-235
+ *   --gravar-traco <f>        grava os blobs válidos de cada frame num ficheiro de traço
+ *   --reproduzir-traco <f>    corre apenas tracking, contagem e classificação sobre um traço gravado
+ *   --distancia-tracking <px> distância máxima de associação do tracking
+ *   --varrimento <f>          descodifica o vídeo uma vez e avalia todas as configurações do ficheiro
+ *   --referencia <f>          contagem correta por tipo, para a exatidão do varrimento
+ *   --threads <n>             threads do varrimento (0 = número de núcleos)
+ *   --gravar-video <f>        grava o vídeo anotado numa thread própria (.avi: MJPG, restantes: mp4v)
+ *   --politica-gravacao <p>   codificador atrasado: novo (descarta o novo), antigo (descarta o mais antigo) ou bloquear
+ *   --estatisticas <f>        exporta no fim as estatísticas por tipo (junta as do ficheiro, se já existir)
+ *   --linhas                  segmentação linha a linha com buffers circulares (menos memória)
+ *   --metricas-porta <porta>  serve as métricas (Prometheus) em http://127.0.0.1:<porta>/metrics
+ *   --metricas-ficheiro <f>   escreve as métricas (Prometheus) no ficheiro a cada segundo
  */
-int main() {
+int main(int argc, char* argv[]) {
     // Configurações Iniciais
     std::string nome_video = "video1.mp4";
-    int limiar_binarizacao;
-
-    if (nome_video == "video1.mp4") {
-        limiar_binarizacao = 110;
-    }
-    else if (nome_video == "video2.mp4") {
-        limiar_binarizacao = 120;
+    bool modo_tempo_real = false;
+    std::string fonte_tempo_real;
+    PoliticaSobrecarga politica_sobrecarga = POLITICA_PROCESSAR_MAIS_RECENTE;
+    double orcamento_latencia_ms = 100.0;
+    const size_t capacidade_fila_tempo_real = 4;
+    int num_segmentos = -1;
+    const double segundos_sobreposicao_segmentos = 2.0;
+    std::string ficheiro_y4m, ficheiro_i420;
+    int largura_i420 = 0, altura_i420 = 0;
+    bool gama_completa_i420 = false;
+    bool segmentacao_em_linhas = false;
+    std::string ficheiro_gravar_traco, ficheiro_reproduzir_traco;
+    int distancia_tracking = 0;
+    std::string ficheiro_varrimento, ficheiro_referencia;
+    std::string ficheiro_video_anotado;
+    std::string ficheiro_estatisticas;
+    PoliticaGravacao politica_gravacao = GRAVACAO_DESCARTAR_NOVO;
+    const int buffers_gravacao = 8;
+    int num_threads_varrimento = 0;
+    int porta_metricas = 0;
+    std::string ficheiro_metricas;
+
+    for (int i = 1; i < argc; i++) {
+        std::string argumento = argv[i];
+        bool tem_valor = (i + 1 < argc);
+
+        if (argumento == "--video" && tem_valor) {
+            nome_video = argv[++i];
+        }
+        else if (argumento == "--tempo-real" && tem_valor) {
+            modo_tempo_real = true;
+            fonte_tempo_real = argv[++i];
+        }
+        else if (argumento == "--politica" && tem_valor) {
+            if (!politicaSobrecargaDeTexto(argv[++i], politica_sobrecarga)) {
+                std::cerr << "Erro: Politica de sobrecarga desconhecida (use antigo, recente ou dizimar).\n";
+                return 1;
+            }
+        }
+        else if (argumento == "--orcamento-ms" && tem_valor) {
+            orcamento_latencia_ms = std::atof(argv[++i]);
+        }
+        else if (argumento == "--segmentos" && tem_valor) {
+            num_segmentos = std::atoi(argv[++i]);
+        }
+        else if (argumento == "--y4m" && tem_valor) {
+            ficheiro_y4m = argv[++i];
+        }
+        else if (argumento == "--i420" && tem_valor) {
+            ficheiro_i420 = argv[++i];
+        }
+        else if (argumento == "--dimensoes" && tem_valor) {
+            std::string dimensoes = argv[++i];
+            size_t separador = dimensoes.find('x');
+            if (separador != std::string::npos) {
+                largura_i420 = std::atoi(dimensoes.c_str());
+                altura_i420 = std::atoi(dimensoes.c_str() + separador + 1);
+            }
+        }
+        else if (argumento == "--gama-completa") {
+            gama_completa_i420 = true;
+        }
+        else if (argumento == "--gravar-traco" && tem_valor) {
+            ficheiro_gravar_traco = argv[++i];
+        }
+        else if (argumento == "--reproduzir-traco" && tem_valor) {
+            ficheiro_reproduzir_traco = argv[++i];
+        }
+        else if (argumento == "--distancia-tracking" && tem_valor) {
+            distancia_tracking = std::atoi(argv[++i]);
+        }
+        else if (argumento == "--varrimento" && tem_valor) {
+            ficheiro_varrimento = argv[++i];
+        }
+        else if (argumento == "--referencia" && tem_valor) {
+            ficheiro_referencia = argv[++i];
+        }
+        else if (argumento == "--threads" && tem_valor) {
+            num_threads_varrimento = std::atoi(argv[++i]);
+        }
+        else if (argumento == "--gravar-video" && tem_valor) {
+            ficheiro_video_anotado = argv[++i];
+        }
+        else if (argumento == "--politica-gravacao" && tem_valor) {
+            if (!politicaGravacaoDeTexto(argv[++i], politica_gravacao)) {
+                std::cerr << "Erro: Politica de gravacao desconhecida (use novo, antigo ou bloquear).\n";
+                return 1;
+            }
+        }
+        else if (argumento == "--estatisticas" && tem_valor) {
+            ficheiro_estatisticas = argv[++i];
+        }
+        else if (argumento == "--linhas") {
+            segmentacao_em_linhas = true;
+        }
+        else if (argumento == "--metricas-porta" && tem_valor) {
+            porta_metricas = std::atoi(argv[++i]);
+        }
+        else if (argumento == "--metricas-ficheiro" && tem_valor) {
+            ficheiro_metricas = argv[++i];
+        }
+        else {
+            std::cerr << "Erro: Argumento invalido: " << argumento << "\n";
+            return 1;
+        }
     }
 
-    int distancia_minima_tracking = 40;
-    cv::VideoCapture video(nome_video);
-    if (!video.isOpened()) {
-        std::cerr << "Erro: Nao foi possivel abrir o ficheiro de video.\n";
+    // O traço é gravado pelo ciclo de frames sequencial (interativo ou YUV)
+    if (!ficheiro_gravar_traco.empty() && (num_segmentos >= 0 || !ficheiro_varrimento.empty())) {
+        std::cerr << "Erro: --gravar-traco nao pode ser combinado com --segmentos nem com --varrimento.\n";
         return 1;
     }
 
-    int largura = static_cast<int>(video.get(cv::CAP_PROP_FRAME_WIDTH));
-    int altura = static_cast<int>(video.get(cv::CAP_PROP_FRAME_HEIGHT));
-
-    const int linha_de_contagem_y = altura / 3;
-    int proximo_id_objeto = 0;
-    std::map<int, cv::Point> objetos_rastreados;
-    std::map<int, bool> objetos_ja_contados;
-    std::map<std::string, int> contagem_por_tipo;
-    double valor_total_euros = 0.0;
-    int total_moedas_contadas = 0;
-
-    std::vector<std::string> tipos = { "1c", "2c", "5c", "10c", "20c", "50c", "1euro", "2euro" };
-    for (const auto& tipo : tipos) contagem_por_tipo[tipo] = 0;
+    // As métricas só são publicadas pelos modos que processam frames (interativo, tempo real, YUV e segmentos)
+    if ((porta_metricas > 0 || !ficheiro_metricas.empty()) && (!ficheiro_varrimento.empty() || !ficheiro_reproduzir_traco.empty())) {
+        std::cerr << "Erro: --metricas-porta/--metricas-ficheiro nao podem ser combinados com --varrimento nem com --reproduzir-traco.\n";
+        return 1;
+    }
 
-    int tecla_pressionada = 0;
-    while (tecla_pressionada != 'q') {
-        cv::Mat frame_original;
-        video >> frame_original;
-        if (frame_original.empty()) break;
+    // O vídeo anotado só é produzido pelo ciclo de frames interativo/tempo real
+    bool fonte_yuv = !ficheiro_y4m.empty() || !ficheiro_i420.empty();
+    if (!ficheiro_video_anotado.empty()
+        && (num_segmentos >= 0 || fonte_yuv || !ficheiro_varrimento.empty() || !ficheiro_reproduzir_traco.empty())) {
+        std::cerr << "Erro: --gravar-video nao pode ser combinado com --segmentos, --y4m/--i420, --varrimento nem --reproduzir-traco.\n";
+        return 1;
+    }
 
-        // PREPARAÇÃO E PROCESSAMENTO DA IMAGEM
-        IVC* img_cor = vc_imagem_nova(largura, altura, 3, 255);
-        memcpy(img_cor->data, frame_original.data, largura * altura * 3);
+    // O varrimento avalia várias configurações de uma vez, e a reprodução de um traço voltaria a
+    // juntar ao ficheiro do turno moedas já registadas na sessão que gravou o traço
+    if (!ficheiro_estatisticas.empty() && (!ficheiro_varrimento.empty() || !ficheiro_reproduzir_traco.empty())) {
+        std::cerr << "Erro: --estatisticas nao pode ser combinado com --varrimento nem com --reproduzir-traco.\n";
+        return 1;
+    }
 
-        IVC* img_cinza = vc_imagem_nova(largura, altura, 1, 255);
-        vc_bgr_para_cinzento(img_cor, img_cinza);
+    ParametrosContagem parametros = parametrosParaVideo(nome_video);
+    parametros.segmentacao_em_linhas = segmentacao_em_linhas;
+    if (distancia_tracking > 0) parametros.distancia_minima_tracking = distancia_tracking;
 
-        IVC* img_binaria = vc_imagem_nova(largura, altura, 1, 255);
-        IVC* img_temp = vc_imagem_nova(largura, altura, 1, 255);
+    // Reprodução de um traço de blobs (sem descodificação nem segmentação)
+    if (!ficheiro_reproduzir_traco.empty()) {
+        ResultadoReproducao resultado;
+        if (!reproduzirTraco(ficheiro_reproduzir_traco, parametros, resultado)) {
+            std::cerr << "Erro: Ficheiro de traco ilegivel ou truncado.\n";
+            return 1;
+        }
+        mostrarContagemFinal(resultado.totais);
+        std::cout << "Frames: " << resultado.frames << " | Tempo: " << std::setprecision(3) << resultado.segundos << " segundos";
+        if (resultado.segundos > 0.0) std::cout << " | " << std::setprecision(0) << resultado.frames / resultado.segundos << " fps";
+        std::cout << "\n";
+        return 0;
+    }
 
-        vc_cinzento_para_binario(img_cinza, img_binaria, limiar_binarizacao);
-        vc_cinzento_negativo(img_binaria);
-        vc_binario_abertura(img_binaria, img_binaria, 3, img_temp);
-        vc_binario_fecho(img_binaria, img_binaria, 3, img_temp);
+    // Estatísticas por tipo de moeda; um ficheiro existente traz as sessões anteriores
+    EstatisticasMoedas estatisticas;
+    iniciarEstatisticas(estatisticas, parametros);
+    if (!ficheiro_estatisticas.empty() && std::ifstream(ficheiro_estatisticas).good()
+        && !carregarEstatisticas(estatisticas, ficheiro_estatisticas)) {
+        std::cerr << "Erro: Ficheiro de estatisticas invalido ou de outras regras (video, escala ou bandas).\n";
+        return 1;
+    }
 
-        vc_imagem_free(img_temp);
+    // Varrimento de parâmetros (uma descodificação para todas as configurações, sem janelas)
+    if (!ficheiro_varrimento.empty()) {
+        ResultadoVarrimento resultado;
+        if (!lerConfiguracoesVarrimento(ficheiro_varrimento, parametros, resultado.configuracoes)) {
+            std::cerr << "Erro: Ficheiro de configuracoes invalido.\n";
+            return 1;
+        }
+        std::map<std::string, int> referencia;
+        if (!ficheiro_referencia.empty() && !lerReferenciaContagem(ficheiro_referencia, referencia)) {
+            std::cerr << "Erro: Ficheiro de referencia invalido.\n";
+            return 1;
+        }
+        if (!processarVarrimento(nome_video, num_threads_varrimento, resultado)) {
+            std::cerr << "Erro: Nao foi possivel processar o varrimento.\n";
+            return 1;
+        }
+        if (!ficheiro_referencia.empty()) avaliarVarrimento(resultado, referencia);
+        mostrarResultadoVarrimento(resultado);
+        return 0;
+    }
 
-        // ANÁLISE DE BLOBS E TRACKING
-        cv::Mat imagem_binaria_opencv(altura, largura, CV_8UC1, img_binaria->data);
-        std::vector<std::vector<cv::Point>> contornos;
-        cv::findContours(imagem_binaria_opencv, contornos, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    // Métricas do pipeline (servidas em HTTP e/ou escritas em ficheiro, se pedido)
+    MetricasPipeline metricas;
+    if (porta_metricas > 0 && !metricas.iniciarServidorHttp(porta_metricas)) {
+        std::cerr << "Erro: Nao foi possivel abrir a porta das metricas.\n";
+        return 1;
+    }
+    if (!ficheiro_metricas.empty() && !metricas.iniciarSnapshotFicheiro(ficheiro_metricas, 1000)) {
+        std::cerr << "Erro: Nao foi possivel escrever o ficheiro de metricas.\n";
+        return 1;
+    }
 
-        // Vetores para guardar os blobs válidos e as propriedades correspondentes
-        std::vector<OVC> blobs_validos_frame;
-        std::vector<double> areas_validas_frame;
-        std::vector<double> circularidades_validas_frame;
+    // Capturas YUV descodificadas previamente (sem janelas)
+    if (!ficheiro_y4m.empty() || !ficheiro_i420.empty()) {
+        LeitorYUV leitor;
+        bool aberto = !ficheiro_y4m.empty()
+            ? leitor.abrirY4M(ficheiro_y4m)
+            : leitor.abrirI420(ficheiro_i420, largura_i420, altura_i420, gama_completa_i420);
+        if (!aberto) {
+            std::cerr << "Erro: Nao foi possivel abrir a captura YUV (formato 4:2:0 e dimensoes validas).\n";
+            return 1;
+        }
+        GravadorTraco gravador_traco;
+        if (!ficheiro_gravar_traco.empty() && !gravador_traco.abrir(ficheiro_gravar_traco, leitor.largura(), leitor.altura(), nome_video)) {
+            std::cerr << "Erro: Nao foi possivel criar o ficheiro de traco.\n";
+            return 1;
+        }
+        int resultado = processarFonteYUV(leitor, parametros, metricas, gravador_traco, estatisticas);
+        if (resultado == 0 && !exportarEstatisticasMoedas(estatisticas, ficheiro_estatisticas)) return 1;
+        return resultado;
+    }
 
-        for (const auto& contorno : contornos) {
-            double area = cv::contourArea(contorno);
-            if (area < 1500) continue;
+    // Processamento de um único vídeo por segmentos paralelos (sem janelas)
+    if (num_segmentos >= 0) {
+        ResultadoSegmentos resultado;
+        if (!processarVideoPorSegmentos(parametros, num_segmentos, segundos_sobreposicao_segmentos, resultado, &metricas)) {
+            std::cerr << "Erro: Nao foi possivel processar o video por segmentos.\n";
+            return 1;
+        }
+        mostrarContagemFinal(resultado.totais);
+        juntarEstatisticas(estatisticas, resultado.estatisticas);
+        if (!exportarEstatisticasMoedas(estatisticas, ficheiro_estatisticas)) return 1;
+        std::cout << "Segmentos: " << resultado.num_segmentos << " | Frames do video: " << resultado.frames_video
+            << " | Frames lidos (com sobreposicao): " << resultado.frames_lidos << "\n";
+        std::cout << "Tempo de processamento: " << std::setprecision(2) << resultado.segundos << " segundos.\n";
+        return 0;
+    }
 
-            OVC info_blob = { 0 };
-            calcularPropriedadesBlob(contorno, info_blob);
+    cv::VideoCapture video;
+    CapturaTempoReal captura(politica_sobrecarga, capacidade_fila_tempo_real, orcamento_latencia_ms, parametros.maximo_frames_saltados_tracking);
+    int largura, altura;
+    double fps_fonte;
 
-            if (vc_blob_cor_a_descartar(img_cor, &info_blob, nome_video.c_str())) {
-                continue;
-            }
+    if (modo_tempo_real) {
+        if (!captura.abrir(fonte_tempo_real)) {
+            std::cerr << "Erro: Nao foi possivel abrir a fonte em tempo real.\n";
+            return 1;
+        }
+        largura = captura.largura();
+        altura = captura.altura();
+        fps_fonte = 1000.0 / captura.estatisticas().intervalo_frame_ms;
+    }
+    else {
+        video.open(nome_video);
+        if (!video.isOpened()) {
+            std::cerr << "Erro: Nao foi possivel abrir o ficheiro de video.\n";
+            return 1;
+        }
+        largura = static_cast<int>(video.get(cv::CAP_PROP_FRAME_WIDTH));
+        altura = static_cast<int>(video.get(cv::CAP_PROP_FRAME_HEIGHT));
+        fps_fonte = video.get(cv::CAP_PROP_FPS);
+    }
 
-            
-            // FILTRO DE PROPORÇÃO
-            float proporcao = (float)info_blob.width / (float)info_blob.height;
-            if (proporcao < 0.8f || proporcao > 1.1f) {
-                continue;
-            }
-           
-
-            // FILTRO DE CIRCULARIDADE 
-            double perimetro = calcularPerimetro(contorno);
-            if (perimetro == 0) continue;
-            double circularidade = (4 * 3.14159265359 * area) / (perimetro * perimetro);
-            if (circularidade < 0.40) {
-                continue;
-            }
+    GravadorTraco gravador_traco;
+    if (!ficheiro_gravar_traco.empty() && !gravador_traco.abrir(ficheiro_gravar_traco, largura, altura, nome_video)) {
+        std::cerr << "Erro: Nao foi possivel criar o ficheiro de traco.\n";
+        return 1;
+    }
+    bool traco_gravado = true;
 
-            // Se o blob passou todos os filtros, guarda todas as informações
-            blobs_validos_frame.push_back(info_blob);
-            areas_validas_frame.push_back(area);
-            circularidades_validas_frame.push_back(circularidade); 
+    GravadorVideoAnotado gravador_video(politica_gravacao, buffers_gravacao);
+    if (!ficheiro_video_anotado.empty() && !gravador_video.abrir(ficheiro_video_anotado, largura, altura, fps_fonte)) {
+        std::cerr << "Erro: Nao foi possivel criar o ficheiro de video anotado.\n";
+        return 1;
+    }
 
-            // LÓGICA DE TRACKING E CONTAGEM
-            cv::Point centro_atual(info_blob.xc, info_blob.yc);
-            int id_associado = -1;
-            double menor_distancia = distancia_minima_tracking;
+    // Sessão com as imagens e os contentores reutilizados em todos os frames
+    SessaoContagem sessao;
+    if (!iniciarSessaoContagem(sessao, largura, altura, parametros)) {
+        std::cerr << "Erro: Nao foi possivel alocar as imagens de trabalho.\n";
+        return 1;
+    }
 
-            for (auto const& par : objetos_rastreados) {
-                int id = par.first;
-                cv::Point pos_anterior = par.second;
-                double dist = std::sqrt(std::pow(centro_atual.x - pos_anterior.x, 2) + std::pow(centro_atual.y - pos_anterior.y, 2));
+    VerificadorAlocacoesFrame verificador_alocacoes;
+    FrameCapturado frame_capturado;
+    cv::Mat frame_original;         // Fora do ciclo para que a leitura reutilize o buffer do frame
+    long long indice_frame = -1;
 
-                if (dist < menor_distancia) {
-                    menor_distancia = dist;
-                    id_associado = id;
-                }
-            }
+    int tecla_pressionada = 0;
+    while (tecla_pressionada != 'q') {
+        int frames_decorridos = 1;
 
-            std::string tipo_moeda = identificarTipoMoeda(area, nome_video);
-
-            if (id_associado != -1) {
-                cv::Point pos_anterior = objetos_rastreados[id_associado];
-                objetos_rastreados[id_associado] = centro_atual;
-
-                if (pos_anterior.y >= linha_de_contagem_y && centro_atual.y < linha_de_contagem_y && !objetos_ja_contados[id_associado]) {
-                    total_moedas_contadas++;
-                    objetos_ja_contados[id_associado] = true;
-                    if (tipo_moeda != "Desconhecida") {
-                        contagem_por_tipo[tipo_moeda]++;
-                        if (tipo_moeda == "1c") valor_total_euros += 0.01; else if (tipo_moeda == "2c") valor_total_euros += 0.02;
-                        else if (tipo_moeda == "5c") valor_total_euros += 0.05; else if (tipo_moeda == "10c") valor_total_euros += 0.10;
-                        else if (tipo_moeda == "20c") valor_total_euros += 0.20; else if (tipo_moeda == "50c") valor_total_euros += 0.50;
-                        else if (tipo_moeda == "1euro") valor_total_euros += 1.00; else if (tipo_moeda == "2euro") valor_total_euros += 2.00;
-                    }
-                    
-                }
-            }
-            else {
-                if (centro_atual.y > linha_de_contagem_y) {
-                    objetos_rastreados[proximo_id_objeto] = centro_atual;
-                    objetos_ja_contados[proximo_id_objeto] = false;
-                    proximo_id_objeto++;
-                }
+        if (modo_tempo_real) {
+            if (!captura.lerFrame(frame_capturado)) break;
+            frame_original = frame_capturado.imagem;
+            if (indice_frame >= 0) {
+                frames_decorridos = static_cast<int>(frame_capturado.indice - indice_frame);
             }
+            indice_frame = frame_capturado.indice;
         }
-
-        // PAINEL DOS RESULTADOS
-        vc_desenha_linha_horizontal(img_cor, linha_de_contagem_y, 255, 0, 0);
-
-        for (const auto& blob : blobs_validos_frame) {
-            vc_desenha_caixa_delimitadora(img_cor, (OVC*)&blob);
-            vc_desenha_centro_massa(img_cor, (OVC*)&blob, 5);
+        else {
+            video >> frame_original;
+            indice_frame++;
         }
+        if (frame_original.empty()) break;
+        auto inicio_processamento = std::chrono::steady_clock::now();
+        verificador_alocacoes.iniciarFrame();
 
-        memcpy(frame_original.data, img_cor->data, largura * altura * 3);
-
-        // DESENHAR O TEXTO DAS MOEDAS (COM CIRCULARIDADE)
-        for (size_t i = 0; i < blobs_validos_frame.size(); ++i) {
-            OVC blob_info = blobs_validos_frame[i];
-            double area = areas_validas_frame[i];
-            double circularidade = circularidades_validas_frame[i];
-
-            std::string tipo_moeda = identificarTipoMoeda(area, nome_video);
-
-            if (tipo_moeda != "Desconhecida") {
-                int x_pos = blob_info.x;
-                int y_pos = blob_info.y - 10;
-                if (y_pos < 10) y_pos = blob_info.y + blob_info.height + 20;
-
-                // Passar o valor da circularidade para 2 casas décimais
-                std::stringstream ss;
-                ss << std::fixed << std::setprecision(2) << circularidade;
-                std::string circ_texto = ss.str();
-
-                // Cria o texto final
-                std::string texto_info = tipo_moeda + " (C:" + circ_texto + ")";
+        // PREPARAÇÃO E PROCESSAMENTO DA IMAGEM
+        segmentarMoedas(frame_original, sessao.imagens, parametros);
+        auto fim_segmentacao = std::chrono::steady_clock::now();
 
-                cv::putText(frame_original, texto_info, cv::Point(x_pos, y_pos), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 0), 2);
-                cv::putText(frame_original, texto_info, cv::Point(x_pos, y_pos), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 0), 1);
-            }
+        // ANÁLISE DE BLOBS E TRACKING
+        extrairBlobsValidos(sessao.imagens, parametros, sessao.blobs);
+        auto fim_blobs = std::chrono::steady_clock::now();
+        if (gravador_traco.aberto() && !gravador_traco.gravarFrame(indice_frame, sessao.blobs)) {
+            traco_gravado = false;
+            break;
         }
 
-        // Desenha o painel de informações
-        int pos_y_painel = 30;
-        for (const auto& par : contagem_por_tipo) {
-            std::string texto = par.first + ": " + std::to_string(par.second);
-            cv::putText(frame_original, texto, cv::Point(20, pos_y_painel), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 0), 2);
-            cv::putText(frame_original, texto, cv::Point(20, pos_y_painel), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 255), 1);
-            pos_y_painel += 25;
+        sessao.eventos.clear();
+        atualizarTracking(sessao.tracking, sessao.blobs, parametros, frames_decorridos, indice_frame, sessao.eventos);
+        for (const auto& evento : sessao.eventos) {
+            registarContagem(sessao.totais, evento);
+            metricas.registarContagem(evento);
+            if (registarEstatisticas(estatisticas, evento)) avisarDerivaArea(estatisticas, evento.tipo_moeda);
         }
-        std::stringstream stream;
-        stream << std::fixed << std::setprecision(2) << valor_total_euros;
-        std::string texto_total = "Total: " + stream.str() + " EUR";
-        cv::putText(frame_original, texto_total, cv::Point(20, pos_y_painel + 10), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 0, 0), 2);
-        cv::putText(frame_original, texto_total, cv::Point(20, pos_y_painel + 10), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 1);
+        auto fim_tracking = std::chrono::steady_clock::now();
+
+        desenharResultados(frame_original, sessao, nome_video);
+        verificador_alocacoes.terminarFrame();
 
-        // Exibe as janelas
+        // A codificação é feita na thread do gravador; aqui o frame só é copiado para um buffer
+        if (gravador_video.aberto()) gravador_video.gravarFrame(frame_original);
+
+        // Exibe as janelas (a apresentação do OpenCV fica fora da verificação de alocações)
+        cv::Mat imagem_binaria_opencv(altura, largura, CV_8UC1, sessao.imagens.binaria->data);
         cv::imshow("Resultado Final", frame_original);
         cv::imshow("Imagem Binaria", imagem_binaria_opencv);
+        auto fim_apresentacao = std::chrono::steady_clock::now();
+
+        if (modo_tempo_real) {
+            double tempo_processamento_ms = std::chrono::duration<double, std::milli>(fim_apresentacao - inicio_processamento).count();
+            captura.registarProcessamento(frame_capturado, tempo_processamento_ms);
+            metricas.definirFramesDescartados(captura.framesDescartados());
+        }
 
-        vc_imagem_free(img_cor);
-        vc_imagem_free(img_cinza);
-        vc_imagem_free(img_binaria);
+        metricas.registarEtapa(ETAPA_SEGMENTACAO, fim_segmentacao - inicio_processamento);
+        metricas.registarEtapa(ETAPA_BLOBS, fim_blobs - fim_segmentacao);
+        metricas.registarEtapa(ETAPA_TRACKING, fim_tracking - fim_blobs);
+        metricas.registarEtapa(ETAPA_APRESENTACAO, fim_apresentacao - fim_tracking);
+        metricas.definirObjetosRastreados(static_cast<long long>(sessao.tracking.objetos_rastreados.size()));
+        metricas.registarFrame();
 
         // Gestão de Input do Utilizador
         tecla_pressionada = cv::waitKey(1) & 0xFF;
@@ -332,14 +673,23 @@ int main() {
         }
     }
 
-    std::cout << "\n=== Contagem Final ===\n";
-    std::cout << "Total de moedas contadas: " << total_moedas_contadas << "\n";
-    for (const auto& par : contagem_por_tipo) {
-        std::cout << " - Moedas de " << par.first << ": " << par.second << "\n";
+    terminarSessaoContagem(sessao);
+    traco_gravado = gravador_traco.fechar() && traco_gravado;
+    if (!traco_gravado) std::cerr << "Erro: Nao foi possivel escrever o ficheiro de traco.\n";
+    mostrarContagemFinal(sessao.totais);
+    bool estatisticas_exportadas = exportarEstatisticasMoedas(estatisticas, ficheiro_estatisticas);
+
+    if (gravador_video.aberto()) {
+        gravador_video.fechar();
+        mostrarEstatisticasGravacao(gravador_video.estatisticas());
+    }
+
+    if (modo_tempo_real) {
+        captura.fechar();
+        mostrarEstatisticasTempoReal(captura.estatisticas(), orcamento_latencia_ms);
     }
-    std::cout << "Valor Total Acumulado: " << std::fixed << std::setprecision(2) << valor_total_euros << " EUR\n";
 
     tempoDecorrido();
     video.release();
-    return 0;
-}
\ No newline at end of file
+    return (estatisticas_exportadas && traco_gravado) ? 0 : 1;
+}
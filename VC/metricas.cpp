@@ -0,0 +1,278 @@
+﻿#include "metricas.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef SOCKET TipoSocket;
+#define fecharSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int TipoSocket;
+#define INVALID_SOCKET (-1)
+#define fecharSocket close
+#endif
+
+static const char* const NOMES_ETAPAS[NUM_ETAPAS] = { "segmentacao", "blobs", "tracking", "apresentacao" };
+
+MetricasPipeline::MetricasPipeline() {
+    for (int i = 0; i < NUM_ETAPAS; i++) {
+        duracao_etapa_ns[i] = 0;
+        execucoes_etapa[i] = 0;
+    }
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) moedas_por_tipo[i] = 0;
+}
+
+MetricasPipeline::~MetricasPipeline() {
+    parar();
+}
+
+/**
+ * Função: registarFrame
+ * Descrição: Conta o frame e atualiza o fps (média exponencial do intervalo entre frames).
+ */
+void MetricasPipeline::registarFrame() {
+    int64_t agora_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t anterior_ns = instante_ultimo_frame_ns.exchange(agora_ns, std::memory_order_relaxed);
+    frames_processados.fetch_add(1, std::memory_order_relaxed);
+
+    if (anterior_ns > 0 && agora_ns > anterior_ns) {
+        double fps_instantaneo = 1e9 / static_cast<double>(agora_ns - anterior_ns);
+        // Chamado em simultâneo pelas threads dos segmentos: a média só é substituída se ninguém a alterou entretanto
+        double fps_anterior = fps_atual.load(std::memory_order_relaxed);
+        double fps_novo;
+        do {
+            fps_novo = (fps_anterior == 0.0) ? fps_instantaneo : 0.9 * fps_anterior + 0.1 * fps_instantaneo;
+        } while (!fps_atual.compare_exchange_weak(fps_anterior, fps_novo, std::memory_order_relaxed));
+    }
+}
+
+void MetricasPipeline::registarEtapa(EtapaPipeline etapa, std::chrono::steady_clock::duration duracao) {
+    uint64_t duracao_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duracao).count());
+    duracao_etapa_ns[etapa].fetch_add(duracao_ns, std::memory_order_relaxed);
+    execucoes_etapa[etapa].fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetricasPipeline::registarContagem(const EventoContagem& evento) {
+    if (evento.tipo_moeda == MOEDA_DESCONHECIDA) {
+        moedas_desconhecidas.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    moedas_por_tipo[evento.tipo_moeda].fetch_add(1, std::memory_order_relaxed);
+    valor_total_centimos.fetch_add(static_cast<int64_t>(std::llround(valorMoeda(evento.tipo_moeda) * 100.0)), std::memory_order_relaxed);
+}
+
+void MetricasPipeline::definirObjetosRastreados(long long num_objetos) {
+    objetos_rastreados.store(num_objetos, std::memory_order_relaxed);
+}
+
+void MetricasPipeline::definirFramesDescartados(long long num_frames) {
+    frames_descartados.store(static_cast<uint64_t>(num_frames), std::memory_order_relaxed);
+}
+
+/**
+ * Função: formatoPrometheus
+ * Descrição: Formata todas as métricas no formato de exposição de texto do Prometheus.
+ */
+std::string MetricasPipeline::formatoPrometheus() const {
+    std::ostringstream texto;
+
+    texto << "# HELP vc_frames_processados_total Frames processados.\n";
+    texto << "# TYPE vc_frames_processados_total counter\n";
+    texto << "vc_frames_processados_total " << frames_processados.load(std::memory_order_relaxed) << "\n";
+
+    texto << "# HELP vc_frames_descartados_total Frames descartados por sobrecarga.\n";
+    texto << "# TYPE vc_frames_descartados_total counter\n";
+    texto << "vc_frames_descartados_total " << frames_descartados.load(std::memory_order_relaxed) << "\n";
+
+    texto << "# HELP vc_fps Frames processados por segundo (media exponencial).\n";
+    texto << "# TYPE vc_fps gauge\n";
+    texto << "vc_fps " << std::fixed << std::setprecision(2) << fps_atual.load(std::memory_order_relaxed) << "\n";
+
+    texto << "# HELP vc_etapa_duracao_segundos Duracao de cada etapa do pipeline.\n";
+    texto << "# TYPE vc_etapa_duracao_segundos summary\n";
+    texto << std::setprecision(6);
+    for (int i = 0; i < NUM_ETAPAS; i++) {
+        texto << "vc_etapa_duracao_segundos_sum{etapa=\"" << NOMES_ETAPAS[i] << "\"} "
+            << duracao_etapa_ns[i].load(std::memory_order_relaxed) / 1e9 << "\n";
+        texto << "vc_etapa_duracao_segundos_count{etapa=\"" << NOMES_ETAPAS[i] << "\"} "
+            << execucoes_etapa[i].load(std::memory_order_relaxed) << "\n";
+    }
+
+    texto << "# HELP vc_moedas_contadas_total Moedas que atravessaram a linha de contagem, por tipo.\n";
+    texto << "# TYPE vc_moedas_contadas_total counter\n";
+    for (int i = 0; i < NUM_TIPOS_MOEDA; i++) {
+        texto << "vc_moedas_contadas_total{tipo=\"" << TIPOS_MOEDA[i] << "\"} " << moedas_por_tipo[i].load(std::memory_order_relaxed) << "\n";
+    }
+    texto << "vc_moedas_contadas_total{tipo=\"desconhecida\"} " << moedas_desconhecidas.load(std::memory_order_relaxed) << "\n";
+
+    texto << "# HELP vc_valor_total_euros Valor acumulado das moedas contadas.\n";
+    texto << "# TYPE vc_valor_total_euros gauge\n";
+    texto << "vc_valor_total_euros " << std::setprecision(2) << valor_total_centimos.load(std::memory_order_relaxed) / 100.0 << "\n";
+
+    texto << "# HELP vc_objetos_rastreados Objetos no estado do tracking.\n";
+    texto << "# TYPE vc_objetos_rastreados gauge\n";
+    texto << "vc_objetos_rastreados " << objetos_rastreados.load(std::memory_order_relaxed) << "\n";
+
+    return texto.str();
+}
+
+/**
+ * Função: iniciarServidorHttp
+ * Descrição: Abre um socket em 127.0.0.1:<porta> e serve as métricas numa thread própria.
+ * Retorna: true em caso de sucesso, false se a porta não puder ser usada.
+ */
+bool MetricasPipeline::iniciarServidorHttp(int porta) {
+#ifdef _WIN32
+    WSADATA dados_wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &dados_wsa) != 0) return false;
+#endif
+
+    TipoSocket servidor = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (servidor == INVALID_SOCKET) return false;
+
+    int reutilizar = 1;
+    setsockopt(servidor, SOL_SOCKET, SO_REUSEADDR, (const char*)&reutilizar, sizeof(reutilizar));
+
+    sockaddr_in endereco;
+    memset(&endereco, 0, sizeof(endereco));
+    endereco.sin_family = AF_INET;
+    endereco.sin_port = htons(static_cast<unsigned short>(porta));
+    endereco.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(servidor, (sockaddr*)&endereco, sizeof(endereco)) != 0 || listen(servidor, 4) != 0) {
+        fecharSocket(servidor);
+        return false;
+    }
+
+    socket_servidor = static_cast<intptr_t>(servidor);
+    a_correr = true;
+    thread_servidor = std::thread(&MetricasPipeline::cicloServidor, this);
+    return true;
+}
+
+/**
+ * Função: cicloServidor
+ * Descrição: Atende um pedido de cada vez; GET /metrics (ou /) devolve as métricas.
+ */
+void MetricasPipeline::cicloServidor() {
+    TipoSocket servidor = static_cast<TipoSocket>(socket_servidor);
+
+    while (a_correr) {
+        // Espera limitada para poder terminar a thread quando a_correr passa a false
+        fd_set pedidos;
+        FD_ZERO(&pedidos);
+        FD_SET(servidor, &pedidos);
+        timeval espera = { 0, 200000 };
+        if (select(static_cast<int>(servidor) + 1, &pedidos, NULL, NULL, &espera) <= 0) continue;
+
+        TipoSocket cliente = accept(servidor, NULL, NULL);
+        if (cliente == INVALID_SOCKET) continue;
+
+        // Um cliente que liga e não envia nada não pode prender a thread (nem parar(), que faz join)
+#ifdef _WIN32
+        DWORD limite_ms = 1000;
+        setsockopt(cliente, SOL_SOCKET, SO_RCVTIMEO, (const char*)&limite_ms, sizeof(limite_ms));
+        setsockopt(cliente, SOL_SOCKET, SO_SNDTIMEO, (const char*)&limite_ms, sizeof(limite_ms));
+#else
+        timeval limite = { 1, 0 };
+        setsockopt(cliente, SOL_SOCKET, SO_RCVTIMEO, (const char*)&limite, sizeof(limite));
+        setsockopt(cliente, SOL_SOCKET, SO_SNDTIMEO, (const char*)&limite, sizeof(limite));
+#endif
+
+        char pedido[1024];
+        int recebidos = recv(cliente, pedido, sizeof(pedido) - 1, 0);
+        pedido[recebidos > 0 ? recebidos : 0] = '\0';
+
+        std::string resposta;
+        if (strncmp(pedido, "GET /metrics", 12) == 0 || strncmp(pedido, "GET / ", 6) == 0) {
+            std::string corpo = formatoPrometheus();
+            resposta = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                + std::to_string(corpo.size()) + "\r\nConnection: close\r\n\r\n" + corpo;
+        }
+        else {
+            resposta = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        }
+
+        send(cliente, resposta.c_str(), static_cast<int>(resposta.size()), 0);
+        fecharSocket(cliente);
+    }
+
+    fecharSocket(servidor);
+    socket_servidor = -1;
+}
+
+/**
+ * Função: iniciarSnapshotFicheiro
+ * Descrição: Arranca a thread que escreve as métricas no ficheiro a cada intervalo_ms.
+ */
+bool MetricasPipeline::iniciarSnapshotFicheiro(const std::string& caminho, int intervalo_ms) {
+    caminho_snapshot = caminho;
+    intervalo_snapshot_ms = intervalo_ms > 0 ? intervalo_ms : 1000;
+    if (!escreverSnapshot()) return false;
+
+    a_correr = true;
+    thread_snapshot = std::thread(&MetricasPipeline::cicloSnapshot, this);
+    return true;
+}
+
+void MetricasPipeline::cicloSnapshot() {
+    const int passo_ms = 50;
+    int decorrido_ms = 0;
+
+    while (a_correr) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(passo_ms));
+        decorrido_ms += passo_ms;
+        if (decorrido_ms >= intervalo_snapshot_ms) {
+            escreverSnapshot();
+            decorrido_ms = 0;
+        }
+    }
+}
+
+/**
+ * Função: escreverSnapshot
+ * Descrição: Escreve para um ficheiro temporário e substitui o destino, para que
+ *            quem lê nunca veja um snapshot incompleto.
+ */
+bool MetricasPipeline::escreverSnapshot() const {
+    std::string caminho_temporario = caminho_snapshot + ".tmp";
+    {
+        std::ofstream ficheiro(caminho_temporario, std::ios::binary | std::ios::trunc);
+        if (!ficheiro) return false;
+        ficheiro << formatoPrometheus();
+        if (!ficheiro) return false;
+    }
+#ifdef _WIN32
+    return MoveFileExA(caminho_temporario.c_str(), caminho_snapshot.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(caminho_temporario.c_str(), caminho_snapshot.c_str()) == 0;
+#endif
+}
+
+void MetricasPipeline::parar() {
+    bool havia_snapshot = thread_snapshot.joinable();
+    a_correr = false;
+    if (thread_servidor.joinable()) {
+        thread_servidor.join();
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+    if (havia_snapshot) {
+        thread_snapshot.join();
+        escreverSnapshot();
+    }
+}
@@ -0,0 +1,92 @@
+﻿#ifndef METRICAS_H
+#define METRICAS_H
+
+#include "contagem.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/**
+ * Enumeração: EtapaPipeline
+ * Descrição: Etapas do processamento de um frame com latência medida.
+ */
+enum EtapaPipeline {
+    ETAPA_SEGMENTACAO,      // Cinzento, binarização e morfologia
+    ETAPA_BLOBS,            // Contornos e filtros dos blobs
+    ETAPA_TRACKING,         // Tracking e contagem
+    ETAPA_APRESENTACAO,     // Desenho e janelas
+    NUM_ETAPAS
+};
+
+/**
+ * Classe: MetricasPipeline
+ * Descrição: Contadores e medidores atómicos do pipeline. O ciclo de frames só faz
+ *            escritas atómicas relaxadas; a formatação é feita por quem lê (servidor HTTP
+ *            ou snapshot em ficheiro), em threads próprias.
+ */
+class MetricasPipeline {
+public:
+    MetricasPipeline();
+    ~MetricasPipeline();
+    MetricasPipeline(const MetricasPipeline&) = delete;
+    MetricasPipeline& operator=(const MetricasPipeline&) = delete;
+
+    /**
+     * Regista o fim de um frame e atualiza o fps atual.
+     */
+    void registarFrame();
+
+    void registarEtapa(EtapaPipeline etapa, std::chrono::steady_clock::duration duracao);
+    void registarContagem(const EventoContagem& evento);
+    void definirObjetosRastreados(long long num_objetos);
+    void definirFramesDescartados(long long num_frames);
+
+    /**
+     * Devolve as métricas no formato de texto do Prometheus.
+     */
+    std::string formatoPrometheus() const;
+
+    /**
+     * Serve as métricas em http://127.0.0.1:<porta>/metrics numa thread própria.
+     */
+    bool iniciarServidorHttp(int porta);
+
+    /**
+     * Escreve periodicamente as métricas num ficheiro (substituído atomicamente).
+     */
+    bool iniciarSnapshotFicheiro(const std::string& caminho, int intervalo_ms);
+
+    /**
+     * Pára o servidor e o snapshot (escrevendo um último snapshot).
+     */
+    void parar();
+
+private:
+    void cicloServidor();
+    void cicloSnapshot();
+    bool escreverSnapshot() const;
+
+    std::atomic<uint64_t> frames_processados{ 0 };
+    std::atomic<uint64_t> frames_descartados{ 0 };
+    std::atomic<int64_t> objetos_rastreados{ 0 };
+    std::atomic<double> fps_atual{ 0.0 };
+    std::atomic<int64_t> instante_ultimo_frame_ns{ 0 };
+
+    std::atomic<uint64_t> duracao_etapa_ns[NUM_ETAPAS];
+    std::atomic<uint64_t> execucoes_etapa[NUM_ETAPAS];
+
+    std::atomic<uint64_t> moedas_por_tipo[NUM_TIPOS_MOEDA];
+    std::atomic<uint64_t> moedas_desconhecidas{ 0 };
+    std::atomic<int64_t> valor_total_centimos{ 0 };     // Em cêntimos para evitar somas atómicas em double
+
+    std::atomic<bool> a_correr{ false };
+    std::thread thread_servidor;
+    std::thread thread_snapshot;
+    intptr_t socket_servidor = -1;
+    std::string caminho_snapshot;
+    int intervalo_snapshot_ms = 1000;
+};
+
+#endif // METRICAS_H
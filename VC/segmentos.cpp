@@ -0,0 +1,160 @@
+﻿#include "segmentos.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+/**
+ * Estrutura: TrabalhoSegmento
+ * Descrição: Intervalo de frames de um segmento e o respetivo resultado parcial.
+ */
+struct TrabalhoSegmento {
+    long long inicio = 0;           // Primeiro frame pertencente ao segmento
+    long long fim = 0;              // Primeiro frame do segmento seguinte
+    long long frames_sobreposicao = 0;
+    double fps = 30.0;
+    TotaisContagem totais;
+    EstatisticasMoedas estatisticas;
+    long long frames_lidos = 0;
+    bool sucesso = false;
+};
+
+/**
+ * Função: indiceFrameLido
+ * Descrição: Índice do último frame lido, calculado a partir do seu instante (CAP_PROP_POS_MSEC).
+ *            Depois de um seek, CAP_PROP_POS_FRAMES costuma devolver apenas o valor pedido, enquanto
+ *            o instante é o do frame realmente descodificado (p.ex. o keyframe anterior).
+ * Retorna: o índice, ou -1 se o backend não indicar o instante.
+ */
+static long long indiceFrameLido(cv::VideoCapture& video, double fps) {
+    double instante_ms = video.get(cv::CAP_PROP_POS_MSEC);
+    if (instante_ms <= 0.0) return -1;
+    return std::llround(instante_ms * fps / 1000.0);
+}
+
+/**
+ * Função: processarSegmento
+ * Descrição: Processa um segmento com um cv::VideoCapture próprio.
+ *            A leitura começa frames_sobreposicao antes do início para que o tracking já conheça
+ *            as moedas que estão abaixo da linha. Só contam as passagens em frames do intervalo
+ *            [inicio, fim); as restantes pertencem ao segmento vizinho, pelo que cada moeda
+ *            é contada exatamente uma vez.
+ */
+static void processarSegmento(const ParametrosContagem& parametros, TrabalhoSegmento& trabalho, MetricasPipeline* metricas) {
+    iniciarTotais(trabalho.totais);
+    iniciarEstatisticas(trabalho.estatisticas, parametros);
+
+    cv::VideoCapture video(parametros.nome_video);
+    if (!video.isOpened()) return;
+
+    int largura = static_cast<int>(video.get(cv::CAP_PROP_FRAME_WIDTH));
+    int altura = static_cast<int>(video.get(cv::CAP_PROP_FRAME_HEIGHT));
+
+    long long inicio_leitura = std::max(0LL, trabalho.inicio - trabalho.frames_sobreposicao);
+    if (inicio_leitura > 0) video.set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(inicio_leitura));
+
+    SessaoContagem sessao;
+    if (!iniciarSessaoContagem(sessao, largura, altura, parametros)) return;
+    cv::Mat frame;
+
+    for (long long indice = inicio_leitura; indice < trabalho.fim; indice++) {
+        video >> frame;
+        if (frame.empty()) break;
+        trabalho.frames_lidos++;
+
+        // Mede onde o seek parou pelo instante do primeiro frame. Sem instante, a correção depende da
+        // sobreposição: um seek impreciso dentro dela só desloca os índices dos frames iniciais
+        if (trabalho.frames_lidos == 1 && inicio_leitura > 0) {
+            long long indice_real = indiceFrameLido(video, trabalho.fps);
+            if (indice_real > trabalho.inicio) {
+                // O seek passou o início do segmento: recomeça do princípio e avança sem processar
+                video.set(cv::CAP_PROP_POS_FRAMES, 0.0);
+                long long saltados = 0;
+                while (saltados < inicio_leitura && video.grab()) saltados++;
+                if (saltados < inicio_leitura || !video.read(frame) || frame.empty()) break;
+                indice_real = inicio_leitura;
+            }
+            if (indice_real >= 0) indice = indice_real;
+            if (indice >= trabalho.fim) break;
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        segmentarMoedas(frame, sessao.imagens, parametros);
+        auto t1 = std::chrono::steady_clock::now();
+        extrairBlobsValidos(sessao.imagens, parametros, sessao.blobs);
+        auto t2 = std::chrono::steady_clock::now();
+
+        sessao.eventos.clear();
+        atualizarTracking(sessao.tracking, sessao.blobs, parametros, 1, indice, sessao.eventos);
+        for (const auto& evento : sessao.eventos) {
+            if (evento.indice_frame < trabalho.inicio) continue;
+            registarContagem(trabalho.totais, evento);
+            // O histograma recente é o do segmento, que é uma janela contígua do vídeo
+            if (registarEstatisticas(trabalho.estatisticas, evento)) avisarDerivaArea(trabalho.estatisticas, evento.tipo_moeda);
+            if (metricas) metricas->registarContagem(evento);
+        }
+
+        if (metricas) {
+            metricas->registarEtapa(ETAPA_SEGMENTACAO, t1 - t0);
+            metricas->registarEtapa(ETAPA_BLOBS, t2 - t1);
+            metricas->registarEtapa(ETAPA_TRACKING, std::chrono::steady_clock::now() - t2);
+            metricas->registarFrame();
+        }
+    }
+
+    terminarSessaoContagem(sessao);
+    video.release();
+    trabalho.sucesso = true;
+}
+
+/**
+ * Função: processarVideoPorSegmentos
+ * Descrição: Divide o vídeo em segmentos contíguos, processa-os em paralelo e junta os totais.
+ */
+bool processarVideoPorSegmentos(const ParametrosContagem& parametros, int num_segmentos, double segundos_sobreposicao, ResultadoSegmentos& resultado,
+    MetricasPipeline* metricas) {
+    auto inicio = std::chrono::steady_clock::now();
+
+    cv::VideoCapture video(parametros.nome_video);
+    if (!video.isOpened()) return false;
+    long long total_frames = static_cast<long long>(video.get(cv::CAP_PROP_FRAME_COUNT));
+    double fps = video.get(cv::CAP_PROP_FPS);
+    video.release();
+    if (total_frames <= 0) return false;
+    if (fps <= 0.0) fps = 30.0;
+
+    if (num_segmentos <= 0) num_segmentos = static_cast<int>(std::thread::hardware_concurrency());
+    if (num_segmentos <= 0) num_segmentos = 1;
+    if (num_segmentos > total_frames) num_segmentos = static_cast<int>(total_frames);
+
+    long long frames_sobreposicao = static_cast<long long>(segundos_sobreposicao * fps);
+
+    std::vector<TrabalhoSegmento> trabalhos(num_segmentos);
+    for (int i = 0; i < num_segmentos; i++) {
+        trabalhos[i].inicio = total_frames * i / num_segmentos;
+        trabalhos[i].fim = total_frames * (i + 1) / num_segmentos;
+        trabalhos[i].frames_sobreposicao = frames_sobreposicao;
+        trabalhos[i].fps = fps;
+    }
+
+    std::vector<std::thread> threads;
+    for (auto& trabalho : trabalhos) {
+        threads.emplace_back(processarSegmento, std::cref(parametros), std::ref(trabalho), metricas);
+    }
+    for (auto& thread : threads) thread.join();
+
+    iniciarTotais(resultado.totais);
+    iniciarEstatisticas(resultado.estatisticas, parametros);
+    resultado.num_segmentos = num_segmentos;
+    resultado.frames_video = total_frames;
+    resultado.frames_lidos = 0;
+    for (const auto& trabalho : trabalhos) {
+        if (!trabalho.sucesso) return false;
+        juntarTotais(resultado.totais, trabalho.totais);
+        juntarEstatisticas(resultado.estatisticas, trabalho.estatisticas);
+        resultado.frames_lidos += trabalho.frames_lidos;
+    }
+
+    resultado.segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    return true;
+}
@@ -0,0 +1,34 @@
+﻿#ifndef SEGMENTOS_H
+#define SEGMENTOS_H
+
+#include "contagem.h"
+#include "estatisticas_moedas.h"
+#include "metricas.h"
+
+/**
+ * Estrutura: ResultadoSegmentos
+ * Descrição: Totais combinados do processamento de um vídeo por segmentos.
+ */
+struct ResultadoSegmentos {
+    TotaisContagem totais;
+    EstatisticasMoedas estatisticas;    // Juntadas a partir das estatísticas de cada segmento
+    int num_segmentos = 0;
+    long long frames_video = 0;
+    long long frames_lidos = 0;     // Inclui os frames de sobreposição
+    double segundos = 0.0;          // Tempo de relógio total
+};
+
+/**
+ * Processa um único vídeo dividido em segmentos temporais, cada um numa thread.
+ * Parâmetros:
+ *   - parametros: parâmetros de contagem
+ *   - num_segmentos: número de segmentos (0 usa o número de núcleos disponíveis)
+ *   - segundos_sobreposicao: tempo processado antes do início de cada segmento para aquecer o tracking
+ *   - resultado: recebe os totais combinados
+ *   - metricas: métricas partilhadas pelos segmentos (opcional)
+ * Retorna: true em caso de sucesso, false em caso de erro.
+ */
+bool processarVideoPorSegmentos(const ParametrosContagem& parametros, int num_segmentos, double segundos_sobreposicao, ResultadoSegmentos& resultado,
+    MetricasPipeline* metricas = nullptr);
+
+#endif // SEGMENTOS_H
@@ -0,0 +1,215 @@
+﻿#include "tempo_real.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+/**
+ * Função: CapturaTempoReal (construtor)
+ * Descrição: Guarda a política de sobrecarga; a fonte só é aberta em abrir().
+ */
+CapturaTempoReal::CapturaTempoReal(PoliticaSobrecarga politica, size_t capacidade_fila, double orcamento_latencia_ms, int fator_dizimacao_maximo)
+    : politica(politica), capacidade_fila(capacidade_fila < 1 ? 1 : capacidade_fila), orcamento_latencia_ms(orcamento_latencia_ms),
+    fator_dizimacao_maximo(fator_dizimacao_maximo < 1 ? 1 : fator_dizimacao_maximo) {
+}
+
+CapturaTempoReal::~CapturaTempoReal() {
+    fechar();
+}
+
+/**
+ * Função: abrir
+ * Descrição: Abre a câmara ou o ficheiro e arranca a thread de captura.
+ */
+bool CapturaTempoReal::abrir(const std::string& fonte) {
+    bool e_numero = !fonte.empty() && std::all_of(fonte.begin(), fonte.end(), [](unsigned char c) { return std::isdigit(c) != 0; });
+
+    if (e_numero) {
+        if (!video.open(std::stoi(fonte))) return false;
+        // Reduz o buffer interno do driver para não acumular frames antigos
+        video.set(cv::CAP_PROP_BUFFERSIZE, 1);
+    }
+    else {
+        if (!video.open(fonte)) return false;
+        fonte_e_ficheiro = true;
+    }
+
+    largura_fonte = static_cast<int>(video.get(cv::CAP_PROP_FRAME_WIDTH));
+    altura_fonte = static_cast<int>(video.get(cv::CAP_PROP_FRAME_HEIGHT));
+
+    double fps = video.get(cv::CAP_PROP_FPS);
+    if (fps <= 0.0) fps = 30.0; // Algumas câmaras não reportam o fps
+    stats.intervalo_frame_ms = 1000.0 / fps;
+
+    a_correr = true;
+    thread_captura = std::thread(&CapturaTempoReal::cicloCaptura, this);
+    return true;
+}
+
+/**
+ * Função: cicloCaptura
+ * Descrição: Thread de captura. Lê a fonte continuamente e coloca os frames na fila
+ *            de acordo com a política de sobrecarga.
+ */
+void CapturaTempoReal::cicloCaptura() {
+    const auto intervalo = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::milli>(stats.intervalo_frame_ms));
+    auto proximo_instante = std::chrono::steady_clock::now();
+    long long indice = 0;
+
+    while (a_correr) {
+        // Um ficheiro é lido ao ritmo nominal para simular uma câmara
+        if (fonte_e_ficheiro) {
+            std::this_thread::sleep_until(proximo_instante);
+            proximo_instante += intervalo;
+        }
+
+        if (!video.grab()) break;
+        auto instante = std::chrono::steady_clock::now();
+        long long indice_atual = indice++;
+
+        // Na dizimação, os frames saltados não chegam a ser descodificados
+        int fator = (politica == POLITICA_DIZIMAR) ? fator_dizimacao.load() : 1;
+        if (indice_atual % fator != 0) {
+            std::lock_guard<std::mutex> lock(mutex_fila);
+            stats.frames_capturados++;
+            stats.frames_descartados++;
+            continue;
+        }
+
+        FrameCapturado frame;
+        if (!video.retrieve(frame.imagem) || frame.imagem.empty()) break;
+        frame.indice = indice_atual;
+        frame.instante_captura = instante;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_fila);
+            stats.frames_capturados++;
+
+            // Um frame descartado depois da dizimação abriria um intervalo acima do que o tracking segue
+            if (politica == POLITICA_DIZIMAR) {
+                espaco_disponivel.wait(lock, [this] { return fila.size() < capacidade_fila || !a_correr; });
+            }
+
+            if (politica == POLITICA_PROCESSAR_MAIS_RECENTE) {
+                stats.frames_descartados += static_cast<long long>(fila.size());
+                fila.clear();
+            }
+            else if (fila.size() >= capacidade_fila) {
+                fila.pop_front();
+                stats.frames_descartados++;
+            }
+            fila.push_back(std::move(frame));
+        }
+        frame_disponivel.notify_one();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_fila);
+    fonte_terminada = true;
+    frame_disponivel.notify_all();
+}
+
+/**
+ * Função: lerFrame
+ * Descrição: Retira o próximo frame da fila (bloqueante).
+ * Retorna: true se foi lido um frame, false se a fonte terminou.
+ */
+bool CapturaTempoReal::lerFrame(FrameCapturado& frame) {
+    std::unique_lock<std::mutex> lock(mutex_fila);
+    frame_disponivel.wait(lock, [this] { return !fila.empty() || fonte_terminada || !a_correr; });
+    if (fila.empty()) return false;
+
+    frame = std::move(fila.front());
+    fila.pop_front();
+    lock.unlock();
+    espaco_disponivel.notify_one();
+    return true;
+}
+
+/**
+ * Função: registarProcessamento
+ * Descrição: Atualiza as métricas de lag e ajusta o fator de dizimação ao tempo de processamento.
+ * Parâmetros:
+ *   - frame: frame acabado de processar
+ *   - tempo_processamento_ms: tempo gasto no processamento do frame
+ */
+void CapturaTempoReal::registarProcessamento(const FrameCapturado& frame, double tempo_processamento_ms) {
+    double lag_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame.instante_captura).count();
+
+    std::lock_guard<std::mutex> lock(mutex_fila);
+    stats.frames_processados++;
+    soma_lag_ms += lag_ms;
+    soma_processamento_ms += tempo_processamento_ms;
+    if (lag_ms > stats.lag_maximo_ms) stats.lag_maximo_ms = lag_ms;
+    if (lag_ms > orcamento_latencia_ms) stats.frames_acima_orcamento++;
+
+    int classe = static_cast<int>(lag_ms);
+    if (classe >= NUM_CLASSES_LAG) classe = NUM_CLASSES_LAG - 1;
+    histograma_lag[classe]++;
+
+    // Processa 1 em cada N frames, com N = tempo de processamento recente / intervalo entre frames,
+    // limitado ao intervalo que o tracking consegue seguir
+    processamento_recente_ms = (stats.frames_processados == 1) ? tempo_processamento_ms
+        : 0.9 * processamento_recente_ms + 0.1 * tempo_processamento_ms;
+    if (politica == POLITICA_DIZIMAR) {
+        int fator = static_cast<int>(std::ceil(processamento_recente_ms / stats.intervalo_frame_ms));
+        if (fator > fator_dizimacao_maximo) {
+            stats.frames_fator_limitado++;
+            fator = fator_dizimacao_maximo;
+        }
+        fator_dizimacao = std::max(1, fator);
+    }
+}
+
+/**
+ * Função: estatisticas
+ * Descrição: Devolve uma cópia das métricas atuais (contadores, lag médio, máximo e percentil 99).
+ */
+EstatisticasTempoReal CapturaTempoReal::estatisticas() const {
+    std::lock_guard<std::mutex> lock(mutex_fila);
+    EstatisticasTempoReal resultado = stats;
+    resultado.fator_dizimacao = fator_dizimacao.load();
+
+    if (stats.frames_processados > 0) {
+        resultado.lag_medio_ms = soma_lag_ms / stats.frames_processados;
+        resultado.processamento_medio_ms = soma_processamento_ms / stats.frames_processados;
+
+        long long limite = (stats.frames_processados * 99 + 99) / 100;
+        long long acumulado = 0;
+        for (int i = 0; i < NUM_CLASSES_LAG; i++) {
+            acumulado += histograma_lag[i];
+            if (acumulado >= limite) {
+                resultado.lag_p99_ms = i + 1;
+                break;
+            }
+        }
+    }
+    return resultado;
+}
+
+long long CapturaTempoReal::framesDescartados() const {
+    std::lock_guard<std::mutex> lock(mutex_fila);
+    return stats.frames_descartados;
+}
+
+/**
+ * Função: fechar
+ * Descrição: Pára a thread de captura e liberta a fonte.
+ */
+void CapturaTempoReal::fechar() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_fila);
+        a_correr = false;
+    }
+    frame_disponivel.notify_all();
+    espaco_disponivel.notify_all();
+    if (thread_captura.joinable()) thread_captura.join();
+    video.release();
+}
+
+bool politicaSobrecargaDeTexto(const std::string& texto, PoliticaSobrecarga& politica) {
+    if (texto == "antigo") politica = POLITICA_DESCARTAR_MAIS_ANTIGO;
+    else if (texto == "recente") politica = POLITICA_PROCESSAR_MAIS_RECENTE;
+    else if (texto == "dizimar") politica = POLITICA_DIZIMAR;
+    else return false;
+    return true;
+}
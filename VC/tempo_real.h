@@ -0,0 +1,123 @@
+﻿#ifndef TEMPO_REAL_H
+#define TEMPO_REAL_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Enumeração: PoliticaSobrecarga
+ * Descrição: Define o que fazer com os frames que chegam enquanto o processamento está atrasado.
+ */
+enum PoliticaSobrecarga {
+    POLITICA_DESCARTAR_MAIS_ANTIGO,     // Fila FIFO limitada: quando cheia, descarta o frame mais antigo
+    POLITICA_PROCESSAR_MAIS_RECENTE,    // Processa sempre o último frame e descarta os restantes
+    POLITICA_DIZIMAR                    // Processa 1 em cada N frames, com N ajustado à carga e limitado
+};
+
+/**
+ * Estrutura: FrameCapturado
+ * Descrição: Frame lido da fonte com o índice original e o instante de captura.
+ */
+struct FrameCapturado {
+    cv::Mat imagem;
+    long long indice = -1;                                  // Índice do frame na fonte
+    std::chrono::steady_clock::time_point instante_captura; // Instante em que o frame foi lido
+};
+
+/**
+ * Estrutura: EstatisticasTempoReal
+ * Descrição: Métricas de sobrecarga e atraso (lag) do modo em tempo real.
+ */
+struct EstatisticasTempoReal {
+    long long frames_capturados = 0;
+    long long frames_processados = 0;
+    long long frames_descartados = 0;
+    long long frames_acima_orcamento = 0;   // Frames com lag acima do orçamento de latência
+    double intervalo_frame_ms = 0.0;        // Intervalo nominal entre frames da fonte
+    double processamento_medio_ms = 0.0;
+    double lag_medio_ms = 0.0;
+    double lag_maximo_ms = 0.0;
+    double lag_p99_ms = 0.0;
+    int fator_dizimacao = 1;
+    long long frames_fator_limitado = 0;    // Frames em que a carga pedia um fator acima do máximo
+};
+
+/**
+ * Classe: CapturaTempoReal
+ * Descrição: Lê frames de uma câmara (ou de um ficheiro ao ritmo nominal) numa thread própria,
+ *            para que um frame lento não atrase as leituras seguintes. Aplica a política de
+ *            sobrecarga escolhida e mede o lag entre a captura e o fim do processamento.
+ */
+class CapturaTempoReal {
+public:
+    /**
+     * fator_dizimacao_maximo: maior intervalo entre frames processados que o tracking consegue seguir
+     * (ParametrosContagem::maximo_frames_saltados_tracking). Acima dele a dizimação não salta mais
+     * frames: a fila deixa de descartar e o atraso passa a crescer, sem perder passagens.
+     */
+    CapturaTempoReal(PoliticaSobrecarga politica, size_t capacidade_fila, double orcamento_latencia_ms, int fator_dizimacao_maximo);
+    ~CapturaTempoReal();
+
+    /**
+     * Abre a fonte: um número é interpretado como índice de câmara, o resto como ficheiro/URL.
+     */
+    bool abrir(const std::string& fonte);
+
+    /**
+     * Bloqueia até haver um frame disponível. Retorna false quando a fonte termina.
+     */
+    bool lerFrame(FrameCapturado& frame);
+
+    /**
+     * Regista o fim do processamento de um frame (atualiza lag e fator de dizimação).
+     */
+    void registarProcessamento(const FrameCapturado& frame, double tempo_processamento_ms);
+
+    void fechar();
+
+    int largura() const { return largura_fonte; }
+    int altura() const { return altura_fonte; }
+    EstatisticasTempoReal estatisticas() const;
+    long long framesDescartados() const;
+
+private:
+    void cicloCaptura();
+
+    static const int NUM_CLASSES_LAG = 1000;    // Histograma de lag com classes de 1 ms
+
+    cv::VideoCapture video;
+    PoliticaSobrecarga politica;
+    size_t capacidade_fila;
+    double orcamento_latencia_ms;
+    int fator_dizimacao_maximo;
+    bool fonte_e_ficheiro = false;
+    int largura_fonte = 0, altura_fonte = 0;
+
+    std::thread thread_captura;
+    mutable std::mutex mutex_fila;
+    std::condition_variable frame_disponivel;
+    std::condition_variable espaco_disponivel;  // Na dizimação a captura espera em vez de descartar
+    std::deque<FrameCapturado> fila;
+    std::atomic<bool> a_correr{ false };
+    bool fonte_terminada = false;
+
+    std::atomic<int> fator_dizimacao{ 1 };
+    EstatisticasTempoReal stats;
+    long long histograma_lag[NUM_CLASSES_LAG] = { 0 };
+    double soma_lag_ms = 0.0, soma_processamento_ms = 0.0;
+    double processamento_recente_ms = 0.0;      // Média exponencial usada na dizimação
+};
+
+/**
+ * Função: politicaSobrecargaDeTexto
+ * Descrição: Converte "antigo", "recente" ou "dizimar" na política correspondente.
+ */
+bool politicaSobrecargaDeTexto(const std::string& texto, PoliticaSobrecarga& politica);
+
+#endif // TEMPO_REAL_H
@@ -0,0 +1,177 @@
+﻿#include "traco_blobs.h"
+#include <chrono>
+#include <cstring>
+
+static const char MAGICO_TRACO[4] = { 'V', 'C', 'T', 'R' };
+static const uint32_t VERSAO_TRACO = 1;
+static const uint32_t MAXIMO_BLOBS_FRAME = 1u << 20;   // Proteção contra ficheiros corrompidos
+
+// Conversão entre cada tipo do formato e os seus bits, que são gravados byte a byte em little-endian
+static uint64_t bitsDoValor(uint32_t valor) { return valor; }
+static uint64_t bitsDoValor(int32_t valor) { return static_cast<uint32_t>(valor); }
+static uint64_t bitsDoValor(int64_t valor) { return static_cast<uint64_t>(valor); }
+static uint64_t bitsDoValor(double valor) {
+    uint64_t bits;
+    memcpy(&bits, &valor, sizeof(bits));
+    return bits;
+}
+
+static void valorDosBits(uint64_t bits, uint32_t& valor) { valor = static_cast<uint32_t>(bits); }
+static void valorDosBits(uint64_t bits, int32_t& valor) { valor = static_cast<int32_t>(static_cast<uint32_t>(bits)); }
+static void valorDosBits(uint64_t bits, int64_t& valor) { valor = static_cast<int64_t>(bits); }
+static void valorDosBits(uint64_t bits, double& valor) { memcpy(&valor, &bits, sizeof(valor)); }
+
+template<typename T>
+static void escreverValor(std::ofstream& ficheiro, T valor) {
+    uint64_t bits = bitsDoValor(valor);
+    char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); i++) bytes[i] = static_cast<char>((bits >> (8 * i)) & 0xFF);
+    ficheiro.write(bytes, sizeof(T));
+}
+
+template<typename T>
+static bool lerValor(std::ifstream& ficheiro, T& valor) {
+    unsigned char bytes[sizeof(T)];
+    if (!ficheiro.read(reinterpret_cast<char*>(bytes), sizeof(T))) return false;
+
+    uint64_t bits = 0;
+    for (size_t i = 0; i < sizeof(T); i++) bits |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    valorDosBits(bits, valor);
+    return true;
+}
+
+/**
+ * Função: abrir (GravadorTraco)
+ * Descrição: Cria o ficheiro de traço e escreve o cabeçalho.
+ */
+bool GravadorTraco::abrir(const std::string& caminho, int largura, int altura, const std::string& nome_video) {
+    ficheiro.open(caminho, std::ios::binary | std::ios::trunc);
+    if (!ficheiro) return false;
+
+    ficheiro.write(MAGICO_TRACO, sizeof(MAGICO_TRACO));
+    escreverValor<uint32_t>(ficheiro, VERSAO_TRACO);
+    escreverValor<int32_t>(ficheiro, largura);
+    escreverValor<int32_t>(ficheiro, altura);
+    escreverValor<uint32_t>(ficheiro, static_cast<uint32_t>(nome_video.size()));
+    ficheiro.write(nome_video.data(), nome_video.size());
+    return static_cast<bool>(ficheiro);
+}
+
+/**
+ * Função: gravarFrame
+ * Descrição: Acrescenta ao traço os blobs válidos de um frame (também os frames sem blobs,
+ *            para que a reprodução veja os mesmos intervalos entre frames).
+ */
+bool GravadorTraco::gravarFrame(long long indice_frame, const std::vector<BlobMoeda>& blobs) {
+    escreverValor<int64_t>(ficheiro, indice_frame);
+    escreverValor<uint32_t>(ficheiro, static_cast<uint32_t>(blobs.size()));
+
+    for (const auto& blob : blobs) {
+        const int32_t campos[6] = { blob.info.x, blob.info.y, blob.info.width, blob.info.height, blob.info.xc, blob.info.yc };
+        for (int32_t campo : campos) escreverValor<int32_t>(ficheiro, campo);
+        escreverValor<double>(ficheiro, blob.area);
+        escreverValor<double>(ficheiro, blob.circularidade);
+    }
+    return static_cast<bool>(ficheiro);
+}
+
+bool GravadorTraco::fechar() {
+    if (!ficheiro.is_open()) return true;
+    ficheiro.close();
+    return !ficheiro.fail();    // O failbit fica ativo desde a primeira escrita falhada
+}
+
+/**
+ * Função: abrir (LeitorTraco)
+ * Descrição: Abre o ficheiro de traço e valida o cabeçalho.
+ */
+bool LeitorTraco::abrir(const std::string& caminho) {
+    ficheiro.open(caminho, std::ios::binary);
+    if (!ficheiro) return false;
+
+    char magico[4];
+    uint32_t versao = 0, comprimento_nome = 0;
+    int32_t largura = 0, altura = 0;
+
+    if (!ficheiro.read(magico, sizeof(magico)) || memcmp(magico, MAGICO_TRACO, sizeof(magico)) != 0) return false;
+    if (!lerValor(ficheiro, versao) || versao != VERSAO_TRACO) return false;
+    if (!lerValor(ficheiro, largura) || !lerValor(ficheiro, altura) || !lerValor(ficheiro, comprimento_nome)) return false;
+    if (comprimento_nome > 4096) return false;
+
+    nome_video.resize(comprimento_nome);
+    if (comprimento_nome > 0 && !ficheiro.read(&nome_video[0], comprimento_nome)) return false;
+
+    largura_video = largura;
+    altura_video = altura;
+    return true;
+}
+
+/**
+ * Função: lerFrame
+ * Descrição: Lê um frame do traço. O fim do ficheiro só é um fim válido antes do início de um
+ *            frame; qualquer leitura incompleta a partir daí marca o traço como truncado.
+ */
+bool LeitorTraco::lerFrame(long long& indice_frame, std::vector<BlobMoeda>& blobs) {
+    if (erro_leitura || ficheiro.peek() == std::char_traits<char>::eof()) return false;
+    erro_leitura = true;        // Só volta a false se o frame for lido por inteiro
+
+    int64_t indice = 0;
+    uint32_t num_blobs = 0;
+    if (!lerValor(ficheiro, indice) || !lerValor(ficheiro, num_blobs) || num_blobs > MAXIMO_BLOBS_FRAME) return false;
+
+    blobs.resize(num_blobs);
+    for (auto& blob : blobs) {
+        int32_t campos[6];
+        for (int32_t& campo : campos) {
+            if (!lerValor(ficheiro, campo)) return false;
+        }
+        if (!lerValor(ficheiro, blob.area) || !lerValor(ficheiro, blob.circularidade)) return false;
+
+        blob.info.x = campos[0];
+        blob.info.y = campos[1];
+        blob.info.width = campos[2];
+        blob.info.height = campos[3];
+        blob.info.xc = campos[4];
+        blob.info.yc = campos[5];
+    }
+
+    indice_frame = indice;
+    erro_leitura = false;
+    return true;
+}
+
+/**
+ * Função: reproduzirTraco
+ * Descrição: Reproduz o traço com a mesma lógica de tracking e contagem do processamento normal,
+ *            incluindo o alargamento do raio quando há frames saltados no traço.
+ */
+bool reproduzirTraco(const std::string& caminho, ParametrosContagem parametros, ResultadoReproducao& resultado) {
+    auto inicio = std::chrono::steady_clock::now();
+
+    LeitorTraco leitor;
+    if (!leitor.abrir(caminho)) return false;
+    parametros.nome_video = leitor.nomeVideo();
+
+    EstadoTracking estado;
+    estado.linha_de_contagem_y = leitor.altura() / 3;
+    iniciarTotais(resultado.totais);
+    resultado.frames = 0;
+
+    std::vector<BlobMoeda> blobs;
+    std::vector<EventoContagem> eventos;
+    long long indice_frame = 0, indice_anterior = -1;
+
+    while (leitor.lerFrame(indice_frame, blobs)) {
+        int frames_decorridos = (indice_anterior >= 0) ? static_cast<int>(indice_frame - indice_anterior) : 1;
+        indice_anterior = indice_frame;
+
+        eventos.clear();
+        atualizarTracking(estado, blobs, parametros, frames_decorridos, indice_frame, eventos);
+        for (const auto& evento : eventos) registarContagem(resultado.totais, evento);
+        resultado.frames++;
+    }
+    if (leitor.erroLeitura()) return false;
+
+    resultado.segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    return true;
+}
@@ -0,0 +1,82 @@
+﻿#ifndef TRACO_BLOBS_H
+#define TRACO_BLOBS_H
+
+#include "contagem.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+ * Formato do ficheiro de traço (binário, little-endian, escrito byte a byte em qualquer plataforma):
+ *   Cabeçalho: "VCTR" | versão (u32) | largura (i32) | altura (i32) | comprimento do nome (u32) | nome do vídeo
+ *   Por frame: índice do frame (i64) | número de blobs (u32) | blobs
+ *   Por blob:  x, y, width, height, xc, yc (i32) | área (f64) | circularidade (f64)
+ */
+
+/**
+ * Classe: GravadorTraco
+ * Descrição: Grava os blobs válidos de cada frame num ficheiro de traço.
+ */
+class GravadorTraco {
+public:
+    bool abrir(const std::string& caminho, int largura, int altura, const std::string& nome_video);
+    bool gravarFrame(long long indice_frame, const std::vector<BlobMoeda>& blobs);
+
+    /**
+     * Fecha o ficheiro. Retorna: false se alguma escrita tiver falhado (p.ex. disco cheio).
+     */
+    bool fechar();
+    bool aberto() const { return ficheiro.is_open(); }
+
+private:
+    std::ofstream ficheiro;
+};
+
+/**
+ * Classe: LeitorTraco
+ * Descrição: Lê sequencialmente um ficheiro de traço gravado por GravadorTraco.
+ */
+class LeitorTraco {
+public:
+    bool abrir(const std::string& caminho);
+
+    /**
+     * Lê o próximo frame. Retorna false no fim do ficheiro ou se estiver truncado/corrompido;
+     * nesse caso erroLeitura() distingue os dois.
+     */
+    bool lerFrame(long long& indice_frame, std::vector<BlobMoeda>& blobs);
+    bool erroLeitura() const { return erro_leitura; }
+
+    int largura() const { return largura_video; }
+    int altura() const { return altura_video; }
+    const std::string& nomeVideo() const { return nome_video; }
+
+private:
+    std::ifstream ficheiro;
+    bool erro_leitura = false;          // Frame incompleto ou inválido (o fim só é válido entre frames)
+    int largura_video = 0, altura_video = 0;
+    std::string nome_video;
+};
+
+/**
+ * Estrutura: ResultadoReproducao
+ * Descrição: Totais e desempenho de uma reprodução de traço.
+ */
+struct ResultadoReproducao {
+    TotaisContagem totais;
+    long long frames = 0;
+    double segundos = 0.0;
+};
+
+/**
+ * Corre apenas o tracking, a contagem e a classificação sobre os blobs gravados no traço.
+ * Parâmetros:
+ *   - caminho: ficheiro de traço
+ *   - parametros: parâmetros de tracking; o nome do vídeo (regras de classificação) vem do traço
+ *   - resultado: recebe os totais
+ * Retorna: true em caso de sucesso, false se o ficheiro não puder ser lido ou estiver truncado.
+ */
+bool reproduzirTraco(const std::string& caminho, ParametrosContagem parametros, ResultadoReproducao& resultado);
+
+#endif // TRACO_BLOBS_H
@@ -0,0 +1,247 @@
+﻿#include "varrimento.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+/**
+ * Função: aplicarChaveVarrimento
+ * Descrição: Aplica um par chave=valor aos parâmetros.
+ * Retorna: true se a chave for conhecida.
+ */
+static bool aplicarChaveVarrimento(const std::string& chave, const std::string& valor, ParametrosContagem& parametros) {
+    const char* texto = valor.c_str();
+    if (chave == "limiar") parametros.limiar_binarizacao = std::atoi(texto);
+    else if (chave == "area_minima") parametros.area_minima = std::atof(texto);
+    else if (chave == "proporcao_minima") parametros.proporcao_minima = static_cast<float>(std::atof(texto));
+    else if (chave == "proporcao_maxima") parametros.proporcao_maxima = static_cast<float>(std::atof(texto));
+    else if (chave == "circularidade") parametros.circularidade_minima = std::atof(texto);
+    else if (chave == "escala_areas") parametros.escala_areas = std::atof(texto);
+    else if (chave == "distancia_tracking") parametros.distancia_minima_tracking = std::atoi(texto);
+    else if (chave == "kernel") parametros.tamanho_kernel_morfologia = std::atoi(texto);
+    else return false;
+    return true;
+}
+
+/**
+ * Função: lerConfiguracoesVarrimento
+ * Descrição: Lê uma configuração por linha do ficheiro de configurações.
+ */
+bool lerConfiguracoesVarrimento(const std::string& caminho, const ParametrosContagem& base, std::vector<ConfiguracaoVarrimento>& configuracoes) {
+    std::ifstream ficheiro(caminho);
+    if (!ficheiro) return false;
+
+    std::string linha;
+    while (std::getline(ficheiro, linha)) {
+        if (!linha.empty() && linha.back() == '\r') linha.pop_back();
+        size_t inicio = linha.find_first_not_of(" \t");
+        if (inicio == std::string::npos || linha[inicio] == '#') continue;
+
+        ConfiguracaoVarrimento configuracao;
+        configuracao.descricao = linha.substr(inicio);
+        configuracao.parametros = base;
+
+        std::istringstream campos(configuracao.descricao);
+        std::string par;
+        while (campos >> par) {
+            size_t igual = par.find('=');
+            if (igual == std::string::npos || !aplicarChaveVarrimento(par.substr(0, igual), par.substr(igual + 1), configuracao.parametros)) return false;
+        }
+        // A abertura/fecho de vc.c só aceitam kernels ímpares; com um kernel par a morfologia seria ignorada sem aviso
+        int kernel = configuracao.parametros.tamanho_kernel_morfologia;
+        if (configuracao.parametros.escala_areas <= 0.0 || kernel < 1 || kernel % 2 == 0) return false;
+
+        configuracoes.push_back(configuracao);
+    }
+    return !configuracoes.empty();
+}
+
+/**
+ * Função: lerReferenciaContagem
+ * Descrição: Lê as quantidades corretas por tipo de moeda.
+ */
+bool lerReferenciaContagem(const std::string& caminho, std::map<std::string, int>& referencia) {
+    std::ifstream ficheiro(caminho);
+    if (!ficheiro) return false;
+
+    std::string tipo;
+    int quantidade = 0;
+    while (ficheiro >> tipo >> quantidade) {
+        if (tipoMoedaDeTexto(tipo) == MOEDA_DESCONHECIDA) return false;
+        referencia[tipo] = quantidade;
+    }
+    return ficheiro.eof();
+}
+
+/**
+ * Estrutura: SincronizacaoVarrimento
+ * Descrição: Entrega de frames às threads. Cada novo frame incrementa a geração;
+ *            a thread de descodificação espera que todas as threads o terminem.
+ */
+struct SincronizacaoVarrimento {
+    std::mutex mutex;
+    std::condition_variable novo_frame;
+    std::condition_variable frame_concluido;
+    const cv::Mat* frame = nullptr;
+    long long indice_frame = 0;
+    long long geracao = 0;
+    int threads_pendentes = 0;
+    bool terminar = false;
+};
+
+/**
+ * Função: cicloThreadVarrimento
+ * Descrição: Processa, em cada frame entregue, as configuracoes indice_thread, indice_thread + num_threads, ...
+ */
+static void cicloThreadVarrimento(SincronizacaoVarrimento& sincronizacao, std::vector<ConfiguracaoVarrimento>& configuracoes,
+    std::vector<SessaoContagem>& sessoes, int indice_thread, int num_threads) {
+    long long ultima_geracao = 0;
+
+    while (true) {
+        const cv::Mat* frame;
+        long long indice_frame;
+        {
+            std::unique_lock<std::mutex> bloqueio(sincronizacao.mutex);
+            sincronizacao.novo_frame.wait(bloqueio, [&] { return sincronizacao.terminar || sincronizacao.geracao != ultima_geracao; });
+            if (sincronizacao.terminar) return;
+            ultima_geracao = sincronizacao.geracao;
+            frame = sincronizacao.frame;
+            indice_frame = sincronizacao.indice_frame;
+        }
+
+        for (size_t i = indice_thread; i < configuracoes.size(); i += num_threads) {
+            ConfiguracaoVarrimento& configuracao = configuracoes[i];
+            SessaoContagem& sessao = sessoes[i];
+            auto inicio = std::chrono::steady_clock::now();
+
+            segmentarMoedas(*frame, sessao.imagens, configuracao.parametros);
+            extrairBlobsValidos(sessao.imagens, configuracao.parametros, sessao.blobs);
+            sessao.eventos.clear();
+            atualizarTracking(sessao.tracking, sessao.blobs, configuracao.parametros, 1, indice_frame, sessao.eventos);
+            for (const auto& evento : sessao.eventos) registarContagem(sessao.totais, evento);
+
+            configuracao.segundos_processamento += std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+        }
+
+        {
+            std::lock_guard<std::mutex> bloqueio(sincronizacao.mutex);
+            if (--sincronizacao.threads_pendentes == 0) sincronizacao.frame_concluido.notify_one();
+        }
+    }
+}
+
+/**
+ * Função: processarVarrimento
+ * Descrição: Descodifica o vídeo uma vez e distribui cada frame por todas as configurações.
+ *            Usa dois frames alternados: enquanto as threads processam um, é descodificado o outro.
+ */
+bool processarVarrimento(const std::string& nome_video, int num_threads, ResultadoVarrimento& resultado) {
+    auto inicio = std::chrono::steady_clock::now();
+    std::vector<ConfiguracaoVarrimento>& configuracoes = resultado.configuracoes;
+    if (configuracoes.empty()) return false;
+
+    cv::VideoCapture video(nome_video);
+    if (!video.isOpened()) return false;
+    int largura = static_cast<int>(video.get(cv::CAP_PROP_FRAME_WIDTH));
+    int altura = static_cast<int>(video.get(cv::CAP_PROP_FRAME_HEIGHT));
+
+    if (num_threads <= 0) num_threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (num_threads <= 0) num_threads = 1;
+    num_threads = std::min(num_threads, static_cast<int>(configuracoes.size()));
+
+    std::vector<SessaoContagem> sessoes(configuracoes.size());
+    bool sessoes_criadas = true;
+    for (size_t i = 0; i < configuracoes.size(); i++) {
+        configuracoes[i].segundos_processamento = 0.0;
+        if (!iniciarSessaoContagem(sessoes[i], largura, altura, configuracoes[i].parametros)) sessoes_criadas = false;
+    }
+    if (!sessoes_criadas) {
+        for (auto& sessao : sessoes) terminarSessaoContagem(sessao);
+        return false;
+    }
+
+    SincronizacaoVarrimento sincronizacao;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back(cicloThreadVarrimento, std::ref(sincronizacao), std::ref(configuracoes), std::ref(sessoes), t, num_threads);
+    }
+
+    cv::Mat frames[2];
+    int atual = 0;
+    double segundos_descodificacao = 0.0;
+    long long indice_frame = 0;
+
+    auto inicio_leitura = std::chrono::steady_clock::now();
+    bool ha_frame = video.read(frames[atual]) && !frames[atual].empty();
+    segundos_descodificacao += std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio_leitura).count();
+
+    while (ha_frame) {
+        {
+            std::lock_guard<std::mutex> bloqueio(sincronizacao.mutex);
+            sincronizacao.frame = &frames[atual];
+            sincronizacao.indice_frame = indice_frame;
+            sincronizacao.threads_pendentes = num_threads;
+            sincronizacao.geracao++;
+        }
+        sincronizacao.novo_frame.notify_all();
+
+        // Descodifica o próximo frame enquanto as threads processam o atual
+        inicio_leitura = std::chrono::steady_clock::now();
+        ha_frame = video.read(frames[1 - atual]) && !frames[1 - atual].empty();
+        segundos_descodificacao += std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio_leitura).count();
+
+        {
+            std::unique_lock<std::mutex> bloqueio(sincronizacao.mutex);
+            sincronizacao.frame_concluido.wait(bloqueio, [&] { return sincronizacao.threads_pendentes == 0; });
+        }
+
+        atual = 1 - atual;
+        indice_frame++;
+    }
+
+    {
+        std::lock_guard<std::mutex> bloqueio(sincronizacao.mutex);
+        sincronizacao.terminar = true;
+    }
+    sincronizacao.novo_frame.notify_all();
+    for (auto& thread : threads) thread.join();
+
+    for (size_t i = 0; i < configuracoes.size(); i++) {
+        configuracoes[i].totais = sessoes[i].totais;
+        terminarSessaoContagem(sessoes[i]);
+    }
+    video.release();
+
+    resultado.frames = indice_frame;
+    resultado.num_threads = num_threads;
+    resultado.segundos_descodificacao = segundos_descodificacao;
+    resultado.segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    return true;
+}
+
+/**
+ * Função: avaliarVarrimento
+ * Descrição: Erro absoluto = soma por tipo de |contadas - referência|; as moedas desconhecidas
+ *            não correspondem a nenhum tipo e por isso não reduzem o erro.
+ */
+void avaliarVarrimento(ResultadoVarrimento& resultado, const std::map<std::string, int>& referencia) {
+    int total_referencia = 0;
+    for (const auto& par : referencia) total_referencia += par.second;
+    resultado.com_referencia = true;
+
+    for (auto& configuracao : resultado.configuracoes) {
+        int erro = 0;
+        for (int i = 0; i < NUM_TIPOS_MOEDA; i++) {
+            auto esperado = referencia.find(TIPOS_MOEDA[i]);
+            int n_esperado = (esperado != referencia.end()) ? esperado->second : 0;
+            erro += std::abs(configuracao.totais.contagem_por_tipo[i] - n_esperado);
+        }
+
+        configuracao.erro_absoluto = erro;
+        configuracao.exatidao = (total_referencia > 0) ? std::max(0.0, 1.0 - static_cast<double>(erro) / total_referencia) : (erro == 0 ? 1.0 : 0.0);
+    }
+}
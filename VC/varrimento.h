@@ -0,0 +1,73 @@
+﻿#ifndef VARRIMENTO_H
+#define VARRIMENTO_H
+
+#include "contagem.h"
+#include <string>
+#include <vector>
+
+/*
+ * Ficheiro de configurações: uma configuração por linha, com pares chave=valor separados por espaços.
+ * As chaves omitidas mantêm os valores calibrados para o vídeo. Linhas vazias e começadas por '#' são ignoradas.
+ *   limiar=110 area_minima=1500 proporcao_minima=0.8 proporcao_maxima=1.1 circularidade=0.40 escala_areas=1.0
+ * Chaves aceites: limiar, area_minima, proporcao_minima, proporcao_maxima, circularidade, escala_areas,
+ *                 distancia_tracking, kernel.
+ *
+ * Ficheiro de referência (contagem correta): uma linha por tipo, "<tipo> <quantidade>", ex.: "2euro 3".
+ */
+
+/**
+ * Estrutura: ConfiguracaoVarrimento
+ * Descrição: Uma configuração do pipeline e o respetivo resultado.
+ */
+struct ConfiguracaoVarrimento {
+    std::string descricao;          // Linha original do ficheiro de configurações
+    ParametrosContagem parametros;
+    TotaisContagem totais;
+    double segundos_processamento = 0.0;    // Tempo gasto nesta configuração (soma dos frames)
+    int erro_absoluto = 0;          // Soma das diferenças por tipo face à referência
+    double exatidao = 0.0;          // 1 - erro_absoluto / total de referência (mínimo 0)
+};
+
+/**
+ * Estrutura: ResultadoVarrimento
+ * Descrição: Resultado de um varrimento de parâmetros.
+ */
+struct ResultadoVarrimento {
+    std::vector<ConfiguracaoVarrimento> configuracoes;
+    long long frames = 0;
+    double segundos = 0.0;          // Tempo de relógio total (inclui a descodificação)
+    double segundos_descodificacao = 0.0;
+    int num_threads = 0;
+    bool com_referencia = false;
+};
+
+/**
+ * Lê o ficheiro de configurações, partindo dos parâmetros base em cada linha.
+ * Retorna: true em caso de sucesso, false se o ficheiro não existir, tiver chaves ou valores inválidos
+ *          (escala_areas <= 0, kernel par ou < 1) ou estiver vazio.
+ */
+bool lerConfiguracoesVarrimento(const std::string& caminho, const ParametrosContagem& base, std::vector<ConfiguracaoVarrimento>& configuracoes);
+
+/**
+ * Lê o ficheiro de referência para um mapa tipo -> quantidade.
+ */
+bool lerReferenciaContagem(const std::string& caminho, std::map<std::string, int>& referencia);
+
+/**
+ * Descodifica cada frame do vídeo uma única vez e processa-o em todas as configurações,
+ * repartidas por um conjunto fixo de threads. O frame seguinte é descodificado enquanto
+ * as threads processam o atual.
+ * Parâmetros:
+ *   - nome_video: vídeo a processar
+ *   - num_threads: número de threads (0 usa o número de núcleos disponíveis)
+ *   - resultado: configurações a avaliar (preenchidas por lerConfiguracoesVarrimento); recebe os totais
+ * Retorna: true em caso de sucesso, false em caso de erro.
+ */
+bool processarVarrimento(const std::string& nome_video, int num_threads, ResultadoVarrimento& resultado);
+
+/**
+ * Calcula o erro e a exatidão de cada configuração face à referência.
+ */
+void avaliarVarrimento(ResultadoVarrimento& resultado, const std::map<std::string, int>& referencia);
+
+#endif // VARRIMENTO_H
@@ -4,6 +4,7 @@
 #include <string.h>
 #include <math.h>
 #include "Header.h" 
+#include "vc_kernels.h"
 
 /**
  * Função: vc_imagem_nova
@@ -65,26 +66,9 @@ int vc_bgr_para_cinzento(IVC* origem, IVC* destino) {
     if ((origem->width != destino->width) || (origem->height != destino->height)) return 0;
     if ((origem->channels != 3) || (destino->channels != 1)) return 0;
 
-    unsigned char* dados_origem = (unsigned char*)origem->data;
-    unsigned char* dados_destino = (unsigned char*)destino->data;
-    int largura = origem->width;
-    int altura = origem->height;
-
-    for (int y = 0; y < altura; y++) {
-        for (int x = 0; x < largura; x++) {
-            long int indice_origem = y * origem->bytesperline + x * origem->channels;
-            long int indice_destino = y * destino->bytesperline + x * destino->channels;
-
-            float valor_azul = (float)dados_origem[indice_origem];
-            float valor_verde = (float)dados_origem[indice_origem + 1];
-            float valor_vermelho = (float)dados_origem[indice_origem + 2];
-
-            unsigned char valor_cinzento = (unsigned char)((valor_vermelho * 0.299) + (valor_verde * 0.587) + (valor_azul * 0.114));
-
-            dados_destino[indice_destino] = valor_cinzento;
-        }
-    }
-    return 1;
+    // Versão especializada (vc_kernels.h); existe sempre para os 3 canais aceites acima
+    return vc_kernel_bgr_para_cinzento(origem->data, origem->bytesperline, origem->channels,
+        destino->data, destino->bytesperline, origem->width, origem->height);
 }
 
 /**
@@ -101,19 +85,24 @@ int vc_cinzento_para_binario(IVC* origem, IVC* destino, int limiar) {
     if ((origem->width != destino->width) || (origem->height != destino->height) || (origem->channels != destino->channels)) return 0;
     if (origem->channels != 1) return 0;
 
-    unsigned char* dados_origem = (unsigned char*)origem->data;
-    unsigned char* dados_destino = (unsigned char*)destino->data;
-    int tamanho_total_pixeis = origem->width * origem->height;
+    return vc_kernel_binarizar(origem->data, destino->data, origem->width * origem->height, limiar, 0);
+}
 
-    for (int i = 0; i < tamanho_total_pixeis; i++) {
-        if (dados_origem[i] > limiar) {
-            dados_destino[i] = 255; // Branco
-        }
-        else {
-            dados_destino[i] = 0;   // Preto
-        }
-    }
-    return 1;
+/**
+ * Função: vc_cinzento_para_binario_invertido
+ * Descrição: Binariza e inverte numa só passagem (equivale a vc_cinzento_para_binario seguido de vc_cinzento_negativo).
+ * Parâmetros:
+ *   - origem: ponteiro para a imagem de origem
+ *   - destino: ponteiro para a imagem de destino
+ *   - limiar: valor de limiarização
+ * Retorna: 1 em caso de sucesso, 0 em caso de erro.
+ */
+int vc_cinzento_para_binario_invertido(IVC* origem, IVC* destino, int limiar) {
+    if (!origem || !destino || !origem->data || !destino->data) return 0;
+    if ((origem->width != destino->width) || (origem->height != destino->height) || (origem->channels != destino->channels)) return 0;
+    if (origem->channels != 1) return 0;
+
+    return vc_kernel_binarizar(origem->data, destino->data, origem->width * origem->height, limiar, 1);
 }
 
 /**
@@ -234,6 +223,51 @@ int vc_desenha_centro_massa(IVC* imagem, OVC* blob, int tamanho_cruz) {
     return 1;
 }
 
+/**
+ * Função: vc_cor_media_a_descartar
+ * Descrição: Converte uma cor média normalizada para HSV e decide se deve ser descartada.
+ * Parâmetros:
+ *   - media_r_norm, media_g_norm, media_b_norm: componentes da cor média no intervalo [0, 1]
+ *   - nome_ficheiro: nome do ficheiro de vídeo para lógicas específicas
+ * Retorna: 1 se a cor for para descartar, 0 caso contrário.
+ */
+static int vc_cor_media_a_descartar(float media_r_norm, float media_g_norm, float media_b_norm, const char* nome_ficheiro) {
+    // Conversão de RGB para HSV
+    float h, s, v;
+    float max_cor = fmaxf(fmaxf(media_r_norm, media_g_norm), media_b_norm);
+    float min_cor = fminf(fminf(media_r_norm, media_g_norm), media_b_norm);
+    float delta = max_cor - min_cor;
+
+    v = max_cor;
+    s = (max_cor == 0.0f) ? 0.0f : delta / max_cor;
+
+    if (s == 0.0f) { h = 0.0f; } // Cinzento, matiz indefinido
+    else {
+        if (max_cor == media_r_norm) { h = 60.0f * fmodf(((media_g_norm - media_b_norm) / delta), 6.0f); }
+        else if (max_cor == media_g_norm) { h = 60.0f * (((media_b_norm - media_r_norm) / delta) + 2.0f); }
+        else { h = 60.0f * (((media_r_norm - media_g_norm) / delta) + 4.0f); }
+        if (h < 0.0f) { h += 360.0f; } // Garante que o matiz está entre 0 e 360
+    }
+
+    // Lógica para definir se uma cor deve ser descartada
+    int cor_e_vermelha = (h >= 340 || h <= 20) && (s > 0.5f) && (v > 0.3f);
+    int cor_e_verde = (h >= 75 && h <= 175) && (s > 0.40f) && (v > 0.20f);
+    int cor_e_azul = (h >= 180 && h <= 280) && (s > 0.4f) && (v > 0.3f);
+    int cor_e_amarela = (h >= 45 && h <= 75) && (s > 0.7f) && (v > 0.6f);
+
+    // Filtro dinâmico para objetos pretos
+    int cor_e_preta = 0;
+    if (strcmp(nome_ficheiro, "video1.mp4") == 0) {
+        cor_e_preta = v < 0.12f; // Limiar de brilho baixo para video1
+    }
+    else if (strcmp(nome_ficheiro, "video2.mp4") == 0) {
+        cor_e_preta = v < 0.18f; // Limiar de brilho baixo para video2
+    }
+
+    // Se a cor corresponder a qualquer um dos critérios, o blob é descartado
+    return (cor_e_vermelha || cor_e_verde || cor_e_azul || cor_e_amarela || cor_e_preta);
+}
+
 /**
  * Função: vc_blob_cor_a_descartar
  * Descrição: Determina se um blob deve ser descartado com base na sua cor média (convertida para HSV).
@@ -271,40 +305,66 @@ int vc_blob_cor_a_descartar(IVC* imagem_cor, OVC* info_blob, const char* nome_fi
     float media_g_norm = ((float)soma_g / contagem_pixeis) / 255.0f;
     float media_b_norm = ((float)soma_b / contagem_pixeis) / 255.0f;
 
-    // Conversão de RGB para HSV
-    float h, s, v;
-    float max_cor = fmaxf(fmaxf(media_r_norm, media_g_norm), media_b_norm);
-    float min_cor = fminf(fminf(media_r_norm, media_g_norm), media_b_norm);
-    float delta = max_cor - min_cor;
+    return vc_cor_media_a_descartar(media_r_norm, media_g_norm, media_b_norm, nome_ficheiro);
+}
 
-    v = max_cor;
-    s = (max_cor == 0.0f) ? 0.0f : delta / max_cor;
+/**
+ * Função: vc_blob_cor_a_descartar_yuv
+ * Descrição: Igual a vc_blob_cor_a_descartar, mas lê a cor diretamente dos planos Y, U e V
+ *            de uma imagem YUV 4:2:0 (crominância com metade da resolução).
+ * Parâmetros:
+ *   - luma: plano Y
+ *   - croma_u, croma_v: planos U (Cb) e V (Cr)
+ *   - info_blob: ponteiro para a estrutura OVC do blob
+ *   - gama_completa: 1 se a luma usar a gama 0-255, 0 se usar a gama limitada 16-235
+ *   - nome_ficheiro: nome do ficheiro de vídeo para lógicas específicas
+ * Retorna: 1 se a cor for para descartar, 0 caso contrário.
+ */
+int vc_blob_cor_a_descartar_yuv(IVC* luma, IVC* croma_u, IVC* croma_v, OVC* info_blob, int gama_completa, const char* nome_ficheiro) {
+    if (!luma || !croma_u || !croma_v || !info_blob || !luma->data || !croma_u->data || !croma_v->data) return 0;
 
-    if (s == 0.0f) { h = 0.0f; } // Cinzento, matiz indefinido
-    else {
-        if (max_cor == media_r_norm) { h = 60.0f * fmodf(((media_g_norm - media_b_norm) / delta), 6.0f); }
-        else if (max_cor == media_g_norm) { h = 60.0f * (((media_b_norm - media_r_norm) / delta) + 2.0f); }
-        else { h = 60.0f * (((media_r_norm - media_g_norm) / delta) + 4.0f); }
-        if (h < 0.0f) { h += 360.0f; } // Garante que o matiz está entre 0 e 360
+    // Amostragem de cor na mesma região de interesse usada na versão BGR
+    int tamanho_roi = 10;
+    int metade_roi = tamanho_roi / 2;
+    long long soma_y = 0, soma_u = 0, soma_v = 0;
+    int contagem_pixeis = 0;
+
+    for (int y = info_blob->yc - metade_roi; y <= info_blob->yc + metade_roi; y++) {
+        for (int x = info_blob->xc - metade_roi; x <= info_blob->xc + metade_roi; x++) {
+            if (x >= 0 && x < luma->width && y >= 0 && y < luma->height) {
+                soma_y += luma->data[y * luma->bytesperline + x];
+                soma_u += croma_u->data[(y / 2) * croma_u->bytesperline + (x / 2)];
+                soma_v += croma_v->data[(y / 2) * croma_v->bytesperline + (x / 2)];
+                contagem_pixeis++;
+            }
+        }
     }
 
-    // Lógica para definir se uma cor deve ser descartada
-    int cor_e_vermelha = (h >= 340 || h <= 20) && (s > 0.5f) && (v > 0.3f);
-    int cor_e_verde = (h >= 75 && h <= 175) && (s > 0.40f) && (v > 0.20f);
-    int cor_e_azul = (h >= 180 && h <= 280) && (s > 0.4f) && (v > 0.3f);
-    int cor_e_amarela = (h >= 45 && h <= 75) && (s > 0.7f) && (v > 0.6f);
+    if (contagem_pixeis == 0) return 0; // Evita divisão por zero
 
-    // Filtro dinâmico para objetos pretos
-    int cor_e_preta = 0;
-    if (strcmp(nome_ficheiro, "video1.mp4") == 0) {
-        cor_e_preta = v < 0.12f; // Limiar de brilho baixo para video1
+    float media_y = (float)soma_y / contagem_pixeis;
+    float media_u = (float)soma_u / contagem_pixeis - 128.0f;
+    float media_v = (float)soma_v / contagem_pixeis - 128.0f;
+
+    // Conversão de YCbCr (BT.601) para RGB; a conversão é linear, por isso converter a média basta
+    float r, g, b;
+    if (gama_completa) {
+        r = media_y + 1.402f * media_v;
+        g = media_y - 0.344136f * media_u - 0.714136f * media_v;
+        b = media_y + 1.772f * media_u;
     }
-    else if (strcmp(nome_ficheiro, "video2.mp4") == 0) {
-        cor_e_preta = v < 0.18f; // Limiar de brilho baixo para video2
+    else {
+        float y_escalado = 1.164f * (media_y - 16.0f);
+        r = y_escalado + 1.596f * media_v;
+        g = y_escalado - 0.392f * media_u - 0.813f * media_v;
+        b = y_escalado + 2.017f * media_u;
     }
 
-    // Se a cor corresponder a qualquer um dos critérios, o blob é descartado
-    return (cor_e_vermelha || cor_e_verde || cor_e_azul || cor_e_amarela || cor_e_preta);
+    float media_r_norm = fminf(fmaxf(r, 0.0f), 255.0f) / 255.0f;
+    float media_g_norm = fminf(fmaxf(g, 0.0f), 255.0f) / 255.0f;
+    float media_b_norm = fminf(fmaxf(b, 0.0f), 255.0f) / 255.0f;
+
+    return vc_cor_media_a_descartar(media_r_norm, media_g_norm, media_b_norm, nome_ficheiro);
 }
 
  /**
@@ -326,6 +386,9 @@ int vc_binario_erosao(IVC* origem, IVC* destino, int tamanho_kernel) {
     unsigned char* dados_destino = destino->data;
     int metade_kernel = tamanho_kernel / 2;
 
+    // Versão especializada (vc_kernels.h), quando existe para o tamanho do kernel
+    if (vc_kernel_morfologia_binaria(dados_origem, dados_destino, largura, altura, bytes_por_linha, tamanho_kernel, 1)) return 1;
+
     // Copia a imagem para o destino para não processar a mesma imagem que está a ser lida
     memcpy(dados_destino, dados_origem, largura * altura);
 
@@ -366,6 +429,8 @@ int vc_binario_dilatacao(IVC* origem, IVC* destino, int tamanho_kernel) {
     unsigned char* dados_destino = destino->data;
     int metade_kernel = tamanho_kernel / 2;
 
+    if (vc_kernel_morfologia_binaria(dados_origem, dados_destino, largura, altura, bytes_por_linha, tamanho_kernel, 0)) return 1;
+
     memcpy(dados_destino, dados_origem, largura * altura);
 
     for (int y = metade_kernel; y < altura - metade_kernel; y++) {
@@ -418,6 +483,106 @@ int vc_binario_fecho(IVC* origem, IVC* destino, int tamanho_kernel, IVC* temp) {
     return 1;
 }
 
+/**
+ * Função: vc_morfologia_linha
+ * Descrição: Versão genérica da erosão/dilatação de uma linha, usada quando não há especialização.
+ * Parâmetros:
+ *   - linhas: as tamanho_kernel linhas vizinhas (a linha central é linhas[tamanho_kernel / 2])
+ *   - destino: linha de destino
+ *   - largura: número de píxeis da linha
+ *   - tamanho_kernel: tamanho do elemento estruturante
+ *   - erosao: 1 para erosão (mínimo), 0 para dilatação (máximo)
+ */
+static void vc_morfologia_linha(const unsigned char* const* linhas, unsigned char* destino, int largura, int tamanho_kernel, int erosao) {
+    int metade_kernel = tamanho_kernel / 2;
+
+    memcpy(destino, linhas[metade_kernel], largura);
+    for (int x = metade_kernel; x < largura - metade_kernel; x++) {
+        unsigned char valor = erosao ? 255 : 0;
+        for (int ky = 0; ky < tamanho_kernel; ky++) {
+            for (int kx = -metade_kernel; kx <= metade_kernel; kx++) {
+                unsigned char vizinho = linhas[ky][x + kx];
+                if (erosao ? (vizinho < valor) : (vizinho > valor)) valor = vizinho;
+            }
+        }
+        destino[x] = valor;
+    }
+}
+
+/**
+ * Função: vc_segmentacao_em_linhas
+ * Descrição: Produz a máscara das moedas (cinzento -> binário invertido -> abertura -> fecho)
+ *            linha a linha, sem imagens intermédias completas. Cada etapa guarda apenas as
+ *            últimas tamanho_kernel linhas num buffer circular; o resultado é idêntico ao da
+ *            sequência vc_bgr_para_cinzento, vc_cinzento_para_binario_invertido,
+ *            vc_binario_abertura e vc_binario_fecho.
+ * Parâmetros:
+ *   - origem: imagem BGR (3 canais) ou luma/cinzento (1 canal)
+ *   - mascara: imagem binária de destino (1 canal, mesmas dimensões)
+ *   - limiar: valor de limiarização
+ *   - tamanho_kernel: tamanho do elemento estruturante (ímpar)
+ *   - linhas: buffers circulares, com a largura da origem e pelo menos 4 * tamanho_kernel linhas
+ * Retorna: 1 em caso de sucesso, 0 em caso de erro.
+ */
+int vc_segmentacao_em_linhas(IVC* origem, IVC* mascara, int limiar, int tamanho_kernel, IVC* linhas) {
+    if (!origem || !mascara || !linhas || !origem->data || !mascara->data || !linhas->data) return 0;
+    if (origem->width != mascara->width || origem->height != mascara->height || mascara->channels != 1) return 0;
+    if (origem->channels != 1 && origem->channels != 3) return 0;
+    if (tamanho_kernel < 1 || tamanho_kernel % 2 == 0) return 0;
+    if (linhas->width < origem->width || linhas->channels != 1 || linhas->height < 4 * tamanho_kernel) return 0;
+
+    // Etapas: 0 = binário invertido, 1 = erosão, 2 = dilatação (fim da abertura),
+    //         3 = dilatação, 4 = erosão (fim do fecho, escrita diretamente na máscara)
+    const int num_etapas = 4;
+    const int erosao_etapa[5] = { 0, 1, 0, 0, 1 };
+    int largura = origem->width, altura = origem->height;
+    int metade_kernel = tamanho_kernel / 2;
+    const unsigned char* vizinhas[64];
+
+    if (tamanho_kernel > 64) return 0;
+
+    // A linha y da etapa 0 permite produzir a linha y - e * metade_kernel da etapa e;
+    // depois da última linha de origem continua-se até todas as etapas terminarem
+    for (int y = 0; y < altura + num_etapas * metade_kernel; y++) {
+        if (y < altura) {
+            unsigned char* linha_etapa0 = linhas->data + (long int)(y % tamanho_kernel) * linhas->bytesperline;
+            unsigned char* linha_origem = origem->data + (long int)y * origem->bytesperline;
+
+            if (origem->channels == 3) {
+                if (!vc_kernel_bgr_para_cinzento(linha_origem, origem->bytesperline, 3, linha_etapa0, linhas->bytesperline, largura, 1)) return 0;
+                vc_kernel_binarizar(linha_etapa0, linha_etapa0, largura, limiar, 1);
+            }
+            else {
+                vc_kernel_binarizar(linha_origem, linha_etapa0, largura, limiar, 1);
+            }
+        }
+
+        for (int etapa = 1; etapa <= num_etapas; etapa++) {
+            int linha = y - etapa * metade_kernel;
+            if (linha < 0 || linha >= altura) continue;
+
+            unsigned char* buffer_anterior = linhas->data + (long int)(etapa - 1) * tamanho_kernel * linhas->bytesperline;
+            unsigned char* destino = (etapa == num_etapas)
+                ? mascara->data + (long int)linha * mascara->bytesperline
+                : linhas->data + (long int)(etapa * tamanho_kernel + linha % tamanho_kernel) * linhas->bytesperline;
+
+            // Linhas da margem mantêm o valor da etapa anterior
+            if (linha < metade_kernel || linha >= altura - metade_kernel) {
+                memcpy(destino, buffer_anterior + (long int)(linha % tamanho_kernel) * linhas->bytesperline, largura);
+                continue;
+            }
+
+            for (int k = 0; k < tamanho_kernel; k++) {
+                vizinhas[k] = buffer_anterior + (long int)((linha - metade_kernel + k) % tamanho_kernel) * linhas->bytesperline;
+            }
+            if (!vc_kernel_morfologia_linha(vizinhas, destino, largura, tamanho_kernel, erosao_etapa[etapa])) {
+                vc_morfologia_linha(vizinhas, destino, largura, tamanho_kernel, erosao_etapa[etapa]);
+            }
+        }
+    }
+    return 1;
+}
+
 /**
   * Função: vc_cinzento_box_blur
   * Descrição: Aplica um filtro de suavização a uma imagem em tons de cinzento.
@@ -0,0 +1,60 @@
+﻿#include "vc_kernels.h"
+
+/*
+ * Instanciações para as configurações usadas em main.cpp:
+ * cinzento a partir de BGR (3 canais), binarização direta e invertida, e erosão/dilatação 3x3
+ * (imagem inteira ou linha a linha).
+ */
+
+/**
+ * Função: vc_kernel_bgr_para_cinzento
+ * Descrição: Escolhe a especialização pelo número de canais.
+ */
+int vc_kernel_bgr_para_cinzento(const unsigned char* origem, int bytes_origem, int canais,
+    unsigned char* destino, int bytes_destino, int largura, int altura) {
+    switch (canais) {
+    case 3: vc_kernels::bgrParaCinzento<3>(origem, bytes_origem, destino, bytes_destino, largura, altura); return 1;
+    default: return 0;
+    }
+}
+
+/**
+ * Função: vc_kernel_binarizar
+ * Descrição: Escolhe a especialização pelo sentido da binarização.
+ */
+int vc_kernel_binarizar(const unsigned char* origem, unsigned char* destino, int num_pixeis, int limiar, int invertido) {
+    if (invertido) vc_kernels::binarizar<true>(origem, destino, num_pixeis, limiar);
+    else vc_kernels::binarizar<false>(origem, destino, num_pixeis, limiar);
+    return 1;
+}
+
+/**
+ * Função: vc_kernel_morfologia_linha
+ * Descrição: Escolhe a especialização pelo tamanho do kernel e pela operação.
+ */
+int vc_kernel_morfologia_linha(const unsigned char* const* linhas, unsigned char* destino, int largura, int tamanho_kernel, int erosao) {
+    switch (tamanho_kernel) {
+    case 3:
+        if (erosao) vc_kernels::morfologiaLinha<3, true>(linhas, destino, largura);
+        else vc_kernels::morfologiaLinha<3, false>(linhas, destino, largura);
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Função: vc_kernel_morfologia_binaria
+ * Descrição: Escolhe a especialização pelo tamanho do kernel e pela operação.
+ */
+int vc_kernel_morfologia_binaria(const unsigned char* origem, unsigned char* destino,
+    int largura, int altura, int bytes_por_linha, int tamanho_kernel, int erosao) {
+    switch (tamanho_kernel) {
+    case 3:
+        if (erosao) vc_kernels::morfologiaBinaria<3, true>(origem, destino, largura, altura, bytes_por_linha);
+        else vc_kernels::morfologiaBinaria<3, false>(origem, destino, largura, altura, bytes_por_linha);
+        return 1;
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,151 @@
+﻿#ifndef VC_KERNELS_H
+#define VC_KERNELS_H
+
+/**
+ * Kernels especializados em tempo de compilação.
+ * O tamanho do kernel, o número de canais e o sentido da binarização são parâmetros de template,
+ * pelo que os ciclos da vizinhança ficam totalmente desenrolados e sem testes por píxel.
+ * As funções vc_* de vc.c escolhem em tempo de execução a especialização adequada através
+ * das funções vc_kernel_* abaixo. A conversão para cinzento (3 canais) e a binarização estão
+ * sempre especializadas; só a morfologia tem versão genérica, para tamanhos de kernel sem especialização.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Conversão BGR para cinzento. Retorna 1 se existir especialização para o número de canais, 0 caso contrário.
+ */
+int vc_kernel_bgr_para_cinzento(const unsigned char* origem, int bytes_origem, int canais,
+    unsigned char* destino, int bytes_destino, int largura, int altura);
+
+/**
+ * Binarização (invertido = 1 produz 255 para valores <= limiar). Retorna 1.
+ */
+int vc_kernel_binarizar(const unsigned char* origem, unsigned char* destino, int num_pixeis, int limiar, int invertido);
+
+/**
+ * Erosão (erosao = 1) ou dilatação binária. Retorna 1 se existir especialização para o tamanho do kernel, 0 caso contrário.
+ */
+int vc_kernel_morfologia_binaria(const unsigned char* origem, unsigned char* destino,
+    int largura, int altura, int bytes_por_linha, int tamanho_kernel, int erosao);
+
+/**
+ * Erosão (erosao = 1) ou dilatação de uma só linha, a partir das tamanho_kernel linhas vizinhas
+ * (linhas[tamanho_kernel / 2] é a linha central). Retorna 1 se existir especialização, 0 caso contrário.
+ */
+int vc_kernel_morfologia_linha(const unsigned char* const* linhas, unsigned char* destino, int largura, int tamanho_kernel, int erosao);
+
+#ifdef __cplusplus
+}
+
+#include <algorithm>
+#include <cstring>
+
+namespace vc_kernels {
+
+/**
+ * Estrutura: Desenrolar
+ * Descrição: Chama f(I) para I = INICIO .. FIM-1, gerando o código de cada iteração em tempo de compilação.
+ */
+template<int INICIO, int FIM>
+struct Desenrolar {
+    template<typename Funcao>
+    static inline void executar(Funcao&& f) {
+        f(INICIO);
+        Desenrolar<INICIO + 1, FIM>::executar(f);
+    }
+};
+
+template<int FIM>
+struct Desenrolar<FIM, FIM> {
+    template<typename Funcao>
+    static inline void executar(Funcao&&) {}
+};
+
+/**
+ * Função: bgrParaCinzento
+ * Descrição: Converte uma imagem BGR (ou BGRx) para tons de cinzento, com os mesmos pesos de vc_bgr_para_cinzento.
+ */
+template<int CANAIS>
+inline void bgrParaCinzento(const unsigned char* origem, int bytes_origem, unsigned char* destino, int bytes_destino, int largura, int altura) {
+    static_assert(CANAIS >= 3, "A conversao para cinzento requer pelo menos 3 canais");
+
+    for (int y = 0; y < altura; y++) {
+        const unsigned char* linha_origem = origem + (size_t)y * bytes_origem;
+        unsigned char* linha_destino = destino + (size_t)y * bytes_destino;
+
+        for (int x = 0; x < largura; x++) {
+            const unsigned char* pixel = linha_origem + x * CANAIS;
+            linha_destino[x] = (unsigned char)((pixel[2] * 0.299) + (pixel[1] * 0.587) + (pixel[0] * 0.114));
+        }
+    }
+}
+
+/**
+ * Função: binarizar
+ * Descrição: Binariza com base num limiar. Com INVERTIDO, os valores <= limiar passam a 255
+ *            (equivalente a binarizar seguido de negativo, numa só passagem).
+ */
+template<bool INVERTIDO>
+inline void binarizar(const unsigned char* origem, unsigned char* destino, int num_pixeis, int limiar) {
+    const unsigned char valor_acima = INVERTIDO ? 0 : 255;
+    const unsigned char valor_abaixo = INVERTIDO ? 255 : 0;
+
+    for (int i = 0; i < num_pixeis; i++) {
+        destino[i] = (origem[i] > limiar) ? valor_acima : valor_abaixo;
+    }
+}
+
+/**
+ * Função: morfologiaLinha
+ * Descrição: Erosão (mínimo) ou dilatação (máximo) de uma linha interior, dadas as TAMANHO_KERNEL
+ *            linhas vizinhas. As colunas da margem mantêm o valor da linha central.
+ */
+template<int TAMANHO_KERNEL, bool EROSAO>
+inline void morfologiaLinha(const unsigned char* const* linhas, unsigned char* destino, int largura) {
+    static_assert(TAMANHO_KERNEL >= 1 && TAMANHO_KERNEL % 2 == 1, "O kernel tem de ter tamanho impar");
+    const int METADE = TAMANHO_KERNEL / 2;
+    const unsigned char* linha_central = linhas[METADE];
+
+    for (int x = 0; x < METADE && x < largura; x++) destino[x] = linha_central[x];
+    for (int x = (largura - METADE > METADE ? largura - METADE : METADE); x < largura; x++) destino[x] = linha_central[x];
+
+    for (int x = METADE; x < largura - METADE; x++) {
+        unsigned char valor = EROSAO ? 255 : 0;
+        Desenrolar<0, TAMANHO_KERNEL>::executar([&](int ky) {
+            Desenrolar<0, TAMANHO_KERNEL>::executar([&](int kx) {
+                unsigned char vizinho = linhas[ky][x - METADE + kx];
+                valor = EROSAO ? std::min(valor, vizinho) : std::max(valor, vizinho);
+            });
+        });
+        destino[x] = valor;
+    }
+}
+
+/**
+ * Função: morfologiaBinaria
+ * Descrição: Erosão (mínimo) ou dilatação (máximo) com um elemento estruturante quadrado.
+ *            As margens de METADE píxeis mantêm o valor de origem, como nas versões genéricas.
+ */
+template<int TAMANHO_KERNEL, bool EROSAO>
+inline void morfologiaBinaria(const unsigned char* origem, unsigned char* destino, int largura, int altura, int bytes_por_linha) {
+    const int METADE = TAMANHO_KERNEL / 2;
+
+    memcpy(destino, origem, (size_t)largura * altura);
+
+    for (int y = METADE; y < altura - METADE; y++) {
+        const unsigned char* linhas[TAMANHO_KERNEL];
+        Desenrolar<0, TAMANHO_KERNEL>::executar([&](int ky) {
+            linhas[ky] = origem + (size_t)(y - METADE + ky) * bytes_por_linha;
+        });
+        morfologiaLinha<TAMANHO_KERNEL, EROSAO>(linhas, destino + (size_t)y * bytes_por_linha, largura);
+    }
+}
+
+} // namespace vc_kernels
+
+#endif // __cplusplus
+
+#endif // VC_KERNELS_H